@@ -14,19 +14,18 @@ main (int argc, char *argv[])
   for (i = 1; i < argc; i++) 
     {
       int fd = open (argv[i]);
+      int size;
       if (fd < 0) 
         {
           printf ("%s: open failed\n", argv[i]);
           success = false;
           continue;
         }
-      for (;;) 
+      size = filesize (fd);
+      if (sendfile (STDOUT_FILENO, fd, 0, size) != size)
         {
-          char buffer[1024];
-          int bytes_read = read (fd, buffer, sizeof buffer);
-          if (bytes_read == 0)
-            break;
-          write (STDOUT_FILENO, buffer, bytes_read);
+          printf ("%s: read failed\n", argv[i]);
+          success = false;
         }
       close (fd);
     }
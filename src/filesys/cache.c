@@ -0,0 +1,333 @@
+#include "filesys/cache.h"
+#include <debug.h>
+#include <string.h>
+#include "devices/timer.h"
+#include "filesys/filesys.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+/* Ticks between two runs of the write-behind daemon. */
+#define WRITE_BEHIND_INTERVAL (5 * TIMER_FREQ)
+
+/* Maximum number of queued read-ahead requests.  Requests that
+   arrive while the queue is full are dropped. */
+#define READAHEAD_MAX 16
+
+/* A cached sector.
+   Disk I/O on an entry, and copying data into it, happen without
+   cache_lock held.  While either is in progress the entry is
+   marked busy: nobody else may touch its data or reuse it, and
+   threads that want it wait on io_done.  Copying data out of an
+   entry also happens without cache_lock, since the caller's
+   buffer may be user memory that faults and reads the file system
+   again.  Any number of readers may copy out at once; an entry
+   with readers is not reused or written into. */
+struct cache_entry
+  {
+    block_sector_t sector;              /* Sector held, if in use. */
+    bool in_use;                        /* Holds a valid sector? */
+    bool dirty;                         /* Modified since last write? */
+    bool accessed;                      /* Used since the clock hand passed? */
+    bool busy;                          /* Being read or written? */
+    int readers;                        /* Threads copying data out. */
+    struct condition io_done;           /* Signaled when busy clears
+                                           or readers drops to 0. */
+    uint8_t data[BLOCK_SECTOR_SIZE];    /* Sector contents. */
+  };
+
+/* The cache proper, protected by cache_lock.  The lock is never
+   held across disk I/O. */
+static struct cache_entry cache[CACHE_SIZE];
+static struct lock cache_lock;
+static size_t clock_hand;
+
+/* Sectors waiting to be read ahead, as a ring buffer protected
+   by readahead_lock. */
+static block_sector_t readahead_queue[READAHEAD_MAX];
+static size_t readahead_head;
+static size_t readahead_cnt;
+static struct lock readahead_lock;
+static struct condition readahead_cond;
+
+static thread_func write_behind_daemon NO_RETURN;
+static thread_func readahead_daemon NO_RETURN;
+
+/* Initializes the buffer cache and starts its helper threads. */
+void
+cache_init (void)
+{
+  size_t i;
+
+  lock_init (&cache_lock);
+  for (i = 0; i < CACHE_SIZE; i++)
+    {
+      cache[i].in_use = false;
+      cache[i].busy = false;
+      cache[i].readers = 0;
+      cond_init (&cache[i].io_done);
+    }
+  clock_hand = 0;
+
+  lock_init (&readahead_lock);
+  cond_init (&readahead_cond);
+  readahead_head = readahead_cnt = 0;
+
+  thread_create ("write-behind", PRI_DEFAULT, write_behind_daemon, NULL);
+  thread_create ("read-ahead", PRI_DEFAULT, readahead_daemon, NULL);
+}
+
+/* Marks E busy, releases the cache lock while doing disk I/O on
+   it with FUNC, then reacquires the lock and wakes up any threads
+   waiting for E.  The cache lock must be held. */
+static void
+cache_io (struct cache_entry *e,
+          void (*func) (struct block *, block_sector_t, void *))
+{
+  ASSERT (lock_held_by_current_thread (&cache_lock));
+  ASSERT (!e->busy);
+
+  e->busy = true;
+  lock_release (&cache_lock);
+  func (fs_device, e->sector, e->data);
+  lock_acquire (&cache_lock);
+  e->busy = false;
+  cond_broadcast (&e->io_done, &cache_lock);
+}
+
+/* Adapts block_write() to cache_io(). */
+static void
+write_sector (struct block *block, block_sector_t sector, void *buffer)
+{
+  block_write (block, sector, buffer);
+}
+
+/* Writes entry E back to disk if it is dirty and not busy.
+   The cache lock must be held, but is released during the
+   write. */
+static void
+cache_writeback (struct cache_entry *e)
+{
+  ASSERT (lock_held_by_current_thread (&cache_lock));
+
+  if (e->in_use && e->dirty && !e->busy)
+    {
+      e->dirty = false;
+      cache_io (e, write_sector);
+    }
+}
+
+/* Returns the entry caching SECTOR, or a null pointer if SECTOR
+   is not cached.  The cache lock must be held. */
+static struct cache_entry *
+cache_lookup (block_sector_t sector)
+{
+  size_t i;
+
+  for (i = 0; i < CACHE_SIZE; i++)
+    if (cache[i].in_use && cache[i].sector == sector)
+      return &cache[i];
+  return NULL;
+}
+
+/* Picks an entry to hold a new sector using the clock algorithm:
+   entries used since the hand last passed get a second chance,
+   and busy entries and entries with readers are skipped.  The victim may still be dirty.
+   If every entry is busy, waits for one of them and returns a
+   null pointer; the caller must then start over.
+   The cache lock must be held. */
+static struct cache_entry *
+cache_evict (void)
+{
+  size_t i;
+
+  ASSERT (lock_held_by_current_thread (&cache_lock));
+
+  /* Two passes are enough: the first clears every accessed bit
+     that would stop the second. */
+  for (i = 0; i < 2 * CACHE_SIZE; i++)
+    {
+      struct cache_entry *e = &cache[clock_hand];
+      clock_hand = (clock_hand + 1) % CACHE_SIZE;
+
+      if (e->busy || e->readers > 0)
+        continue;
+      if (!e->in_use || !e->accessed)
+        return e;
+      e->accessed = false;
+    }
+
+  cond_wait (&cache[clock_hand].io_done, &cache_lock);
+  return NULL;
+}
+
+/* Returns the entry for SECTOR, bringing it into the cache if
+   necessary.  If READ is false the caller will overwrite the
+   whole sector, so its old contents are not read from disk.
+   The cache lock must be held.  It is released while waiting for
+   disk I/O, so other threads can use the cache meanwhile, but is
+   held again on return and the entry is not busy, though it may
+   have readers. */
+static struct cache_entry *
+cache_get (block_sector_t sector, bool read)
+{
+  struct cache_entry *e;
+
+  for (;;)
+    {
+      e = cache_lookup (sector);
+      if (e != NULL)
+        {
+          /* Being read in or written back by someone else. */
+          if (e->busy)
+            {
+              cond_wait (&e->io_done, &cache_lock);
+              continue;
+            }
+          break;
+        }
+
+      e = cache_evict ();
+      if (e == NULL)
+        continue;
+      if (e->in_use && e->dirty)
+        {
+          /* While the lock was dropped for the write, the victim
+             may have been used again, or SECTOR brought in by
+             another thread.  Either way, look again. */
+          cache_writeback (e);
+          if (e->busy || e->readers > 0 || e->dirty || e->accessed
+              || cache_lookup (sector) != NULL)
+            continue;
+        }
+
+      e->sector = sector;
+      e->in_use = true;
+      e->dirty = false;
+      if (read)
+        cache_io (e, block_read);
+      else
+        memset (e->data, 0, BLOCK_SECTOR_SIZE);
+      break;
+    }
+  e->accessed = true;
+  return e;
+}
+
+/* Reads SIZE bytes starting at byte OFS within SECTOR into
+   BUFFER, going to disk only if SECTOR is not cached.  BUFFER may
+   be in user memory: the copy is made without cache_lock held, so
+   a page fault during it may use the cache too. */
+void
+cache_read (block_sector_t sector, void *buffer, int ofs, int size)
+{
+  struct cache_entry *e;
+
+  ASSERT (ofs >= 0 && size >= 0 && ofs + size <= BLOCK_SECTOR_SIZE);
+
+  lock_acquire (&cache_lock);
+  e = cache_get (sector, true);
+  e->readers++;
+  lock_release (&cache_lock);
+
+  memcpy (buffer, e->data + ofs, size);
+
+  lock_acquire (&cache_lock);
+  if (--e->readers == 0)
+    cond_broadcast (&e->io_done, &cache_lock);
+  lock_release (&cache_lock);
+}
+
+/* Writes SIZE bytes from BUFFER into SECTOR starting at byte
+   OFS.  The data reaches disk on eviction, on the next
+   write-behind pass, or at cache_flush().  As in cache_read(),
+   the copy is made without cache_lock held. */
+void
+cache_write (block_sector_t sector, const void *buffer, int ofs, int size)
+{
+  struct cache_entry *e;
+
+  ASSERT (ofs >= 0 && size >= 0 && ofs + size <= BLOCK_SECTOR_SIZE);
+
+  lock_acquire (&cache_lock);
+  for (;;)
+    {
+      e = cache_get (sector, ofs > 0 || size < BLOCK_SECTOR_SIZE);
+      if (e->readers == 0)
+        break;
+      /* E may be reused while we wait, so look it up again. */
+      cond_wait (&e->io_done, &cache_lock);
+    }
+  e->busy = true;
+  e->dirty = true;
+  lock_release (&cache_lock);
+
+  memcpy (e->data + ofs, buffer, size);
+
+  lock_acquire (&cache_lock);
+  e->busy = false;
+  cond_broadcast (&e->io_done, &cache_lock);
+  lock_release (&cache_lock);
+}
+
+/* Asks the read-ahead daemon to bring SECTOR into the cache in
+   the background.  Returns without waiting for the read. */
+void
+cache_readahead (block_sector_t sector)
+{
+  lock_acquire (&readahead_lock);
+  if (readahead_cnt < READAHEAD_MAX)
+    {
+      readahead_queue[(readahead_head + readahead_cnt) % READAHEAD_MAX]
+        = sector;
+      readahead_cnt++;
+      cond_signal (&readahead_cond, &readahead_lock);
+    }
+  lock_release (&readahead_lock);
+}
+
+/* Writes every dirty cached sector to disk.  Sectors busy with
+   an eviction write are left to it. */
+void
+cache_flush (void)
+{
+  size_t i;
+
+  lock_acquire (&cache_lock);
+  for (i = 0; i < CACHE_SIZE; i++)
+    cache_writeback (&cache[i]);
+  lock_release (&cache_lock);
+}
+
+/* Periodically writes dirty sectors back to disk, so that a
+   crash loses at most WRITE_BEHIND_INTERVAL ticks of writes. */
+static void
+write_behind_daemon (void *aux UNUSED)
+{
+  for (;;)
+    {
+      timer_sleep (WRITE_BEHIND_INTERVAL);
+      cache_flush ();
+    }
+}
+
+/* Services read-ahead requests queued by cache_readahead(). */
+static void
+readahead_daemon (void *aux UNUSED)
+{
+  for (;;)
+    {
+      block_sector_t sector;
+
+      lock_acquire (&readahead_lock);
+      while (readahead_cnt == 0)
+        cond_wait (&readahead_cond, &readahead_lock);
+      sector = readahead_queue[readahead_head];
+      readahead_head = (readahead_head + 1) % READAHEAD_MAX;
+      readahead_cnt--;
+      lock_release (&readahead_lock);
+
+      lock_acquire (&cache_lock);
+      cache_get (sector, true);
+      lock_release (&cache_lock);
+    }
+}
@@ -1,11 +1,22 @@
 #include "filesys/directory.h"
 #include <stdio.h>
 #include <string.h>
+#include <hash.h>
 #include <list.h>
 #include "filesys/filesys.h"
 #include "filesys/inode.h"
 #include "threads/malloc.h"
 
+/* A directory's data is a dir_header followed by an open
+   addressing hash table of dir_entry slots.  A name lives in the
+   first slot at or after hash_string(name) modulo the number of
+   slots that is not taken by another entry, so a lookup reads
+   only the slots from there up to the first free one instead of
+   the whole directory.  Removing an entry leaves a tombstone
+   behind, to keep later entries reachable.  When live entries
+   and tombstones together fill three quarters of the table, it
+   is rebuilt, twice as large if needed. */
+
 /* A directory. */
 struct dir 
   {
@@ -13,20 +24,84 @@ struct dir
     off_t pos;                          /* Current position. */
   };
 
+/* Start of a directory's data. */
+struct dir_header
+  {
+    block_sector_t parent;              /* Inode sector of "..". */
+    uint32_t entry_cnt;                 /* Slots in use. */
+    uint32_t fill_cnt;                  /* Slots in use or removed. */
+  };
+
+/* State of a directory slot. */
+enum slot_state
+  {
+    SLOT_FREE,                          /* Never used. */
+    SLOT_IN_USE,                        /* Holds an entry. */
+    SLOT_REMOVED                        /* Held an entry, now removed. */
+  };
+
 /* A single directory entry. */
 struct dir_entry 
   {
     block_sector_t inode_sector;        /* Sector number of header. */
     char name[NAME_MAX + 1];            /* Null terminated file name. */
-    bool in_use;                        /* In use or free? */
+    uint8_t state;                      /* A slot_state. */
   };
 
+/* Returns the byte offset of slot IDX in a directory. */
+static off_t
+slot_ofs (size_t idx)
+{
+  return sizeof (struct dir_header) + idx * sizeof (struct dir_entry);
+}
+
+/* Returns the number of slots in directory INODE. */
+static size_t
+slot_cnt (struct inode *inode)
+{
+  return ((inode_length (inode) - sizeof (struct dir_header))
+          / sizeof (struct dir_entry));
+}
+
+/* Reads directory INODE's header into *H.
+   Returns true if successful, false on failure. */
+static bool
+read_header (struct inode *inode, struct dir_header *h)
+{
+  return inode_read_at (inode, h, sizeof *h, 0) == sizeof *h;
+}
+
+/* Writes *H as directory INODE's header.
+   Returns true if successful, false on failure. */
+static bool
+write_header (struct inode *inode, const struct dir_header *h)
+{
+  return inode_write_at (inode, h, sizeof *h, 0) == sizeof *h;
+}
+
 /* Creates a directory with space for ENTRY_CNT entries in the
-   given SECTOR.  Returns true if successful, false on failure. */
+   given SECTOR, whose parent directory is in PARENT_SECTOR.
+   Returns true if successful, false on failure. */
 bool
-dir_create (block_sector_t sector, size_t entry_cnt)
+dir_create (block_sector_t sector, size_t entry_cnt,
+            block_sector_t parent_sector)
 {
-  return inode_create (sector, entry_cnt * sizeof (struct dir_entry));
+  struct dir_header h;
+  struct inode *inode;
+  bool success;
+
+  ASSERT (entry_cnt > 0);
+
+  if (!inode_create (sector, slot_ofs (entry_cnt), true))
+    return false;
+  inode = inode_open (sector);
+  if (inode == NULL)
+    return false;
+  h.parent = parent_sector;
+  h.entry_cnt = h.fill_cnt = 0;
+  success = write_header (inode, &h);
+  inode_close (inode);
+  return success;
 }
 
 /* Opens and returns the directory for the given INODE, of which
@@ -38,7 +113,7 @@ dir_open (struct inode *inode)
   if (inode != NULL && dir != NULL)
     {
       dir->inode = inode;
-      dir->pos = 0;
+      dir->pos = slot_ofs (0);
       return dir;
     }
   else
@@ -87,32 +162,95 @@ dir_get_inode (struct dir *dir)
    If successful, returns true, sets *EP to the directory entry
    if EP is non-null, and sets *OFSP to the byte offset of the
    directory entry if OFSP is non-null.
-   otherwise, returns false and ignores EP and OFSP. */
+   otherwise, returns false and ignores EP and OFSP.
+   The directory lock must be held. */
 static bool
 lookup (const struct dir *dir, const char *name,
         struct dir_entry *ep, off_t *ofsp) 
 {
   struct dir_entry e;
-  size_t ofs;
-  
+  size_t cnt, home, i;
+
   ASSERT (dir != NULL);
   ASSERT (name != NULL);
 
-  for (ofs = 0; inode_read_at (dir->inode, &e, sizeof e, ofs) == sizeof e;
-       ofs += sizeof e) 
-    if (e.in_use && !strcmp (name, e.name)) 
-      {
-        if (ep != NULL)
-          *ep = e;
-        if (ofsp != NULL)
-          *ofsp = ofs;
-        return true;
-      }
+  cnt = slot_cnt (dir->inode);
+  if (cnt == 0)
+    return false;
+  home = hash_string (name) % cnt;
+  for (i = 0; i < cnt; i++)
+    {
+      off_t ofs = slot_ofs ((home + i) % cnt);
+
+      if (inode_read_at (dir->inode, &e, sizeof e, ofs) != sizeof e
+          || e.state == SLOT_FREE)
+        break;
+      if (e.state == SLOT_IN_USE && !strcmp (name, e.name))
+        {
+          if (ep != NULL)
+            *ep = e;
+          if (ofsp != NULL)
+            *ofsp = ofs;
+          return true;
+        }
+    }
   return false;
 }
 
+/* Stores E in the first slot along its probe sequence in TABLE,
+   an in-memory table of CNT slots, that does not hold an entry. */
+static void
+table_insert (struct dir_entry *table, size_t cnt,
+              const struct dir_entry *e)
+{
+  size_t idx = hash_string (e->name) % cnt;
+
+  while (table[idx].state == SLOT_IN_USE)
+    idx = (idx + 1) % cnt;
+  table[idx] = *e;
+}
+
+/* Rebuilds DIR's hash table with NEW_CNT slots, dropping the
+   removed entries, and updates *H to match.
+   Returns true if successful, false on failure.
+   The directory lock must be held. */
+static bool
+rehash (struct dir *dir, struct dir_header *h, size_t new_cnt)
+{
+  size_t old_cnt = slot_cnt (dir->inode);
+  off_t old_size = old_cnt * sizeof (struct dir_entry);
+  off_t new_size = new_cnt * sizeof (struct dir_entry);
+  struct dir_entry *old, *new;
+  bool success = false;
+  size_t i;
+
+  ASSERT (new_cnt >= old_cnt && new_cnt > h->entry_cnt);
+
+  old = malloc (old_size);
+  new = calloc (new_cnt, sizeof *new);
+  if (old == NULL || new == NULL
+      || inode_read_at (dir->inode, old, old_size, slot_ofs (0)) != old_size)
+    goto done;
+
+  for (i = 0; i < old_cnt; i++)
+    if (old[i].state == SLOT_IN_USE)
+      table_insert (new, new_cnt, &old[i]);
+  if (inode_write_at (dir->inode, new, new_size, slot_ofs (0)) != new_size)
+    goto done;
+
+  h->fill_cnt = h->entry_cnt;
+  success = write_header (dir->inode, h);
+
+ done:
+  free (old);
+  free (new);
+  return success;
+}
+
 /* Searches DIR for a file with the given NAME
    and returns true if one exists, false otherwise.
+   "." names DIR itself and ".." its parent.  Nothing can be
+   found in a directory that has been removed.
    On success, sets *INODE to an inode for the file, otherwise to
    a null pointer.  The caller must close *INODE. */
 bool
@@ -120,14 +258,23 @@ dir_lookup (const struct dir *dir, const char *name,
             struct inode **inode) 
 {
   struct dir_entry e;
+  struct dir_header h;
 
   ASSERT (dir != NULL);
   ASSERT (name != NULL);
 
-  if (lookup (dir, name, &e, NULL))
+  inode_lock_dir (dir->inode);
+  if (inode_is_removed (dir->inode))
+    *inode = NULL;
+  else if (!strcmp (name, "."))
+    *inode = inode_reopen (dir->inode);
+  else if (!strcmp (name, ".."))
+    *inode = read_header (dir->inode, &h) ? inode_open (h.parent) : NULL;
+  else if (lookup (dir, name, &e, NULL))
     *inode = inode_open (e.inode_sector);
   else
     *inode = NULL;
+  inode_unlock_dir (dir->inode);
 
   return *inode != NULL;
 }
@@ -136,12 +283,14 @@ dir_lookup (const struct dir *dir, const char *name,
    file by that name.  The file's inode is in sector
    INODE_SECTOR.
    Returns true if successful, false on failure.
-   Fails if NAME is invalid (i.e. too long) or a disk or memory
-   error occurs. */
+   Fails if NAME is invalid (i.e. too long, "." or ".."), if DIR
+   has been removed, or if a disk or memory error occurs. */
 bool
 dir_add (struct dir *dir, const char *name, block_sector_t inode_sector)
 {
   struct dir_entry e;
+  struct dir_header h;
+  size_t cnt, idx;
   off_t ofs;
   bool success = false;
 
@@ -149,51 +298,72 @@ dir_add (struct dir *dir, const char *name, block_sector_t inode_sector)
   ASSERT (name != NULL);
 
   /* Check NAME for validity. */
-  if (*name == '\0' || strlen (name) > NAME_MAX)
+  if (*name == '\0' || strlen (name) > NAME_MAX
+      || !strcmp (name, ".") || !strcmp (name, ".."))
     return false;
 
-  /* Check that NAME is not in use. */
-  if (lookup (dir, name, NULL, NULL))
+  inode_lock_dir (dir->inode);
+
+  /* Check that DIR still exists and NAME is not in use. */
+  if (inode_is_removed (dir->inode) || !read_header (dir->inode, &h)
+      || lookup (dir, name, NULL, NULL))
     goto done;
 
-  /* Set OFS to offset of free slot.
-     If there are no free slots, then it will be set to the
-     current end-of-file.
-     
-     inode_read_at() will only return a short read at end of file.
-     Otherwise, we'd need to verify that we didn't get a short
-     read due to something intermittent such as low memory. */
-  for (ofs = 0; inode_read_at (dir->inode, &e, sizeof e, ofs) == sizeof e;
-       ofs += sizeof e) 
-    if (!e.in_use)
-      break;
+  /* Keep at least a quarter of the slots free, so that probe
+     sequences stay short and always end at a free slot. */
+  cnt = slot_cnt (dir->inode);
+  if ((h.fill_cnt + 1) * 4 > cnt * 3
+      && !rehash (dir, &h, (h.entry_cnt + 1) * 2 > cnt ? cnt * 2 : cnt))
+    goto done;
+  cnt = slot_cnt (dir->inode);
+
+  /* Find the first slot along NAME's probe sequence that does not
+     hold an entry. */
+  for (idx = hash_string (name) % cnt; ; idx = (idx + 1) % cnt)
+    {
+      ofs = slot_ofs (idx);
+      if (inode_read_at (dir->inode, &e, sizeof e, ofs) != sizeof e)
+        goto done;
+      if (e.state != SLOT_IN_USE)
+        break;
+    }
+  if (e.state == SLOT_FREE)
+    h.fill_cnt++;
+  h.entry_cnt++;
 
   /* Write slot. */
-  e.in_use = true;
+  e.state = SLOT_IN_USE;
   strlcpy (e.name, name, sizeof e.name);
   e.inode_sector = inode_sector;
-  success = inode_write_at (dir->inode, &e, sizeof e, ofs) == sizeof e;
+  success = (inode_write_at (dir->inode, &e, sizeof e, ofs) == sizeof e
+             && write_header (dir->inode, &h));
 
  done:
+  inode_unlock_dir (dir->inode);
   return success;
 }
 
 /* Removes any entry for NAME in DIR.
    Returns true if successful, false on failure,
-   which occurs only if there is no file with the given NAME. */
+   which occurs only if there is no file with the given NAME or
+   if NAME is a directory that is not empty. */
 bool
 dir_remove (struct dir *dir, const char *name) 
 {
   struct dir_entry e;
+  struct dir_header h;
   struct inode *inode = NULL;
+  bool is_dir = false;
   bool success = false;
   off_t ofs;
 
   ASSERT (dir != NULL);
   ASSERT (name != NULL);
 
+  inode_lock_dir (dir->inode);
+
   /* Find directory entry. */
-  if (!lookup (dir, name, &e, &ofs))
+  if (!lookup (dir, name, &e, &ofs) || !read_header (dir->inode, &h))
     goto done;
 
   /* Open inode. */
@@ -201,9 +371,24 @@ dir_remove (struct dir *dir, const char *name)
   if (inode == NULL)
     goto done;
 
+  /* Only empty directories can be removed.  Hold the directory's
+     own lock until it is marked removed, so that nothing can be
+     added to it in the meantime. */
+  is_dir = inode_is_dir (inode);
+  if (is_dir)
+    {
+      struct dir_header child;
+
+      inode_lock_dir (inode);
+      if (!read_header (inode, &child) || child.entry_cnt != 0)
+        goto done;
+    }
+
   /* Erase directory entry. */
-  e.in_use = false;
-  if (inode_write_at (dir->inode, &e, sizeof e, ofs) != sizeof e) 
+  e.state = SLOT_REMOVED;
+  h.entry_cnt--;
+  if (inode_write_at (dir->inode, &e, sizeof e, ofs) != sizeof e
+      || !write_header (dir->inode, &h))
     goto done;
 
   /* Remove inode. */
@@ -211,26 +396,33 @@ dir_remove (struct dir *dir, const char *name)
   success = true;
 
  done:
+  if (is_dir)
+    inode_unlock_dir (inode);
+  inode_unlock_dir (dir->inode);
   inode_close (inode);
   return success;
 }
 
 /* Reads the next directory entry in DIR and stores the name in
    NAME.  Returns true if successful, false if the directory
-   contains no more entries. */
+   contains no more entries.  "." and ".." are never returned. */
 bool
 dir_readdir (struct dir *dir, char name[NAME_MAX + 1])
 {
   struct dir_entry e;
+  bool success = false;
 
+  inode_lock_dir (dir->inode);
   while (inode_read_at (dir->inode, &e, sizeof e, dir->pos) == sizeof e) 
     {
       dir->pos += sizeof e;
-      if (e.in_use)
+      if (e.state == SLOT_IN_USE)
         {
           strlcpy (name, e.name, NAME_MAX + 1);
-          return true;
-        } 
+          success = true;
+          break;
+        }
     }
-  return false;
+  inode_unlock_dir (dir->inode);
+  return success;
 }
@@ -4,19 +4,431 @@
 #include "filesys/file.h"
 #include "filesys/filesys.h"
 #include "filesys/inode.h"
+#include "threads/malloc.h"
+#include "threads/synch.h"
 
 static struct file *free_map_file;   /* Free map file. */
 static struct bitmap *free_map;      /* Free map, one bit per sector. */
+static struct lock free_map_lock;    /* Protects all of the above. */
+
+/* A run of free sectors.
+   The bitmap above is the authoritative record of which sectors
+   are free, and the only one kept on disk.  The extents are an
+   in-memory index over it that lets us find free space without
+   scanning the bitmap from sector 0 on every allocation.
+
+   Extents are kept in an AVL tree ordered by start sector.  Each
+   node also records the size of the largest extent in its
+   subtree, so that the first extent big enough for a request, at
+   or after a given sector, can be found in O(log n) time. */
+struct free_extent
+  {
+    block_sector_t start;            /* First free sector. */
+    size_t cnt;                      /* Number of free sectors. */
+    struct free_extent *left;        /* Extents that start before. */
+    struct free_extent *right;       /* Extents that start after. */
+    int height;                      /* Height of this subtree. */
+    size_t max_cnt;                  /* Largest cnt in this subtree. */
+  };
+
+/* Root of the free extent tree.  Adjacent extents are always
+   merged. */
+static struct free_extent *extent_root;
+
+/* True if extents_release() ran out of memory, so that some free
+   sectors are missing from the tree until the next rebuild. */
+static bool extents_lost;
+
+/* Next-fit cursor: allocations without a better hint start
+   looking here, just past the previous allocation. */
+static block_sector_t next_fit;
+
+static void extents_rebuild (void);
 
 /* Initializes the free map. */
 void
 free_map_init (void) 
 {
+  lock_init (&free_map_lock);
+  extent_root = NULL;
   free_map = bitmap_create (block_size (fs_device));
   if (free_map == NULL)
     PANIC ("bitmap creation failed--file system device is too large");
   bitmap_mark (free_map, FREE_MAP_SECTOR);
   bitmap_mark (free_map, ROOT_DIR_SECTOR);
+  extents_rebuild ();
+}
+
+/* Returns the height of subtree E. */
+static int
+extent_height (const struct free_extent *e)
+{
+  return e != NULL ? e->height : 0;
+}
+
+/* Returns the largest extent size in subtree E. */
+static size_t
+extent_max_cnt (const struct free_extent *e)
+{
+  return e != NULL ? e->max_cnt : 0;
+}
+
+/* Recomputes E's height and max_cnt from its children. */
+static void
+extent_fix (struct free_extent *e)
+{
+  int lh = extent_height (e->left);
+  int rh = extent_height (e->right);
+  size_t lm = extent_max_cnt (e->left);
+  size_t rm = extent_max_cnt (e->right);
+
+  e->height = (lh > rh ? lh : rh) + 1;
+  e->max_cnt = e->cnt;
+  if (lm > e->max_cnt)
+    e->max_cnt = lm;
+  if (rm > e->max_cnt)
+    e->max_cnt = rm;
+}
+
+/* Rotates subtree E left and returns its new root. */
+static struct free_extent *
+extent_rotate_left (struct free_extent *e)
+{
+  struct free_extent *r = e->right;
+
+  e->right = r->left;
+  r->left = e;
+  extent_fix (e);
+  extent_fix (r);
+  return r;
+}
+
+/* Rotates subtree E right and returns its new root. */
+static struct free_extent *
+extent_rotate_right (struct free_extent *e)
+{
+  struct free_extent *l = e->left;
+
+  e->left = l->right;
+  l->right = e;
+  extent_fix (e);
+  extent_fix (l);
+  return l;
+}
+
+/* Restores the AVL balance of subtree E, whose children are
+   balanced and differ in height by at most 2, and returns its new
+   root. */
+static struct free_extent *
+extent_balance (struct free_extent *e)
+{
+  int balance = extent_height (e->left) - extent_height (e->right);
+
+  if (balance > 1)
+    {
+      if (extent_height (e->left->left) < extent_height (e->left->right))
+        e->left = extent_rotate_left (e->left);
+      return extent_rotate_right (e);
+    }
+  else if (balance < -1)
+    {
+      if (extent_height (e->right->right) < extent_height (e->right->left))
+        e->right = extent_rotate_right (e->right);
+      return extent_rotate_left (e);
+    }
+  extent_fix (e);
+  return e;
+}
+
+/* Inserts E into subtree ROOT and returns the new root. */
+static struct free_extent *
+extent_insert (struct free_extent *root, struct free_extent *e)
+{
+  if (root == NULL)
+    {
+      e->left = e->right = NULL;
+      extent_fix (e);
+      return e;
+    }
+  if (e->start < root->start)
+    root->left = extent_insert (root->left, e);
+  else
+    root->right = extent_insert (root->right, e);
+  return extent_balance (root);
+}
+
+/* Removes the extent with the lowest start from subtree ROOT,
+   stores it in *MINP, and returns the new root. */
+static struct free_extent *
+extent_remove_min (struct free_extent *root, struct free_extent **minp)
+{
+  if (root->left == NULL)
+    {
+      *minp = root;
+      return root->right;
+    }
+  root->left = extent_remove_min (root->left, minp);
+  return extent_balance (root);
+}
+
+/* Removes E, which must be in it, from subtree ROOT and returns
+   the new root.  E itself is not freed. */
+static struct free_extent *
+extent_remove (struct free_extent *root, struct free_extent *e)
+{
+  ASSERT (root != NULL);
+
+  if (e->start < root->start)
+    root->left = extent_remove (root->left, e);
+  else if (e->start > root->start)
+    root->right = extent_remove (root->right, e);
+  else
+    {
+      struct free_extent *min;
+
+      ASSERT (root == e);
+      if (e->right == NULL)
+        return e->left;
+      root = extent_remove_min (e->right, &min);
+      min->left = e->left;
+      min->right = root;
+      root = min;
+    }
+  return extent_balance (root);
+}
+
+/* Recomputes max_cnt along the path from subtree ROOT down to E,
+   after E's size or start changed without changing its position
+   in the sort order. */
+static void
+extent_refresh (struct free_extent *root, struct free_extent *e)
+{
+  ASSERT (root != NULL);
+
+  if (e->start < root->start)
+    extent_refresh (root->left, e);
+  else if (e->start > root->start)
+    extent_refresh (root->right, e);
+  extent_fix (root);
+}
+
+/* Returns the extent with the highest start at or before SECTOR,
+   or a null pointer if there is none. */
+static struct free_extent *
+extent_floor (block_sector_t sector)
+{
+  struct free_extent *e = extent_root, *best = NULL;
+
+  while (e != NULL)
+    if (e->start <= sector)
+      {
+        best = e;
+        e = e->right;
+      }
+    else
+      e = e->left;
+  return best;
+}
+
+/* Returns the extent with the lowest start after SECTOR, or a
+   null pointer if there is none. */
+static struct free_extent *
+extent_ceiling (block_sector_t sector)
+{
+  struct free_extent *e = extent_root, *best = NULL;
+
+  while (e != NULL)
+    if (e->start > sector)
+      {
+        best = e;
+        e = e->left;
+      }
+    else
+      e = e->right;
+  return best;
+}
+
+/* Returns the lowest-starting extent in subtree E that starts at
+   or after MIN_START and holds at least CNT sectors, or a null
+   pointer if there is none.  Subtrees without a big enough extent
+   are skipped by their max_cnt, so this takes O(log n) time. */
+static struct free_extent *
+extent_first_fit (struct free_extent *e, block_sector_t min_start,
+                  size_t cnt)
+{
+  struct free_extent *fit;
+
+  if (e == NULL || e->max_cnt < cnt)
+    return NULL;
+  if (e->start < min_start)
+    return extent_first_fit (e->right, min_start, cnt);
+
+  fit = extent_first_fit (e->left, min_start, cnt);
+  if (fit != NULL)
+    return fit;
+  if (e->cnt >= cnt)
+    return e;
+  return extent_first_fit (e->right, min_start, cnt);
+}
+
+/* Frees every extent in subtree E. */
+static void
+extent_destroy (struct free_extent *e)
+{
+  if (e != NULL)
+    {
+      extent_destroy (e->left);
+      extent_destroy (e->right);
+      free (e);
+    }
+}
+
+/* Discards the extent index and rebuilds it from the bitmap. */
+static void
+extents_rebuild (void)
+{
+  size_t start, end;
+
+  extent_destroy (extent_root);
+  extent_root = NULL;
+
+  for (start = bitmap_scan (free_map, 0, 1, false);
+       start != BITMAP_ERROR;
+       start = bitmap_scan (free_map, end, 1, false))
+    {
+      struct free_extent *e;
+
+      end = bitmap_scan (free_map, start, 1, true);
+      if (end == BITMAP_ERROR)
+        end = bitmap_size (free_map);
+
+      e = malloc (sizeof *e);
+      if (e == NULL)
+        PANIC ("OOM building free extent index");
+      e->start = start;
+      e->cnt = end - start;
+      extent_root = extent_insert (extent_root, e);
+
+      if (end == bitmap_size (free_map))
+        break;
+    }
+  extents_lost = false;
+  next_fit = 0;
+}
+
+/* Removes sectors START...START + CNT - 1, which must all lie
+   within free extent E, from the extent index.  Returns false if
+   E would need to be split and memory for the split runs out. */
+static bool
+extent_carve (struct free_extent *e, block_sector_t start, size_t cnt)
+{
+  block_sector_t end = start + cnt;
+  block_sector_t e_end = e->start + e->cnt;
+
+  ASSERT (start >= e->start && end <= e_end);
+
+  if (start == e->start && end == e_end)
+    {
+      extent_root = extent_remove (extent_root, e);
+      free (e);
+    }
+  else if (start == e->start)
+    {
+      /* Still sorts between the same neighbors. */
+      e->start = end;
+      e->cnt -= cnt;
+      extent_refresh (extent_root, e);
+    }
+  else if (end == e_end)
+    {
+      e->cnt -= cnt;
+      extent_refresh (extent_root, e);
+    }
+  else
+    {
+      struct free_extent *tail = malloc (sizeof *tail);
+      if (tail == NULL)
+        return false;
+      e->cnt = start - e->start;
+      extent_refresh (extent_root, e);
+      tail->start = end;
+      tail->cnt = e_end - end;
+      extent_root = extent_insert (extent_root, tail);
+    }
+  return true;
+}
+
+/* Finds CNT consecutive free sectors in the extent index, as
+   close after HINT as possible, and removes them from the index.
+   Falls back to the first run that is big enough anywhere on
+   disk.  Returns the first sector, or BITMAP_ERROR on failure. */
+static block_sector_t
+extents_allocate (size_t cnt, block_sector_t hint)
+{
+  struct free_extent *e;
+
+  /* Right at HINT, inside the extent that contains it. */
+  e = extent_floor (hint);
+  if (e != NULL && hint < e->start + e->cnt
+      && e->start + e->cnt - hint >= cnt
+      && extent_carve (e, hint, cnt))
+    return hint;
+
+  /* At the start of the first big enough extent after HINT, or
+     failing that, anywhere. */
+  e = extent_first_fit (extent_root, hint + 1, cnt);
+  if (e == NULL)
+    e = extent_first_fit (extent_root, 0, cnt);
+  if (e != NULL)
+    {
+      block_sector_t start = e->start;
+      extent_carve (e, start, cnt);
+      return start;
+    }
+  return BITMAP_ERROR;
+}
+
+/* Returns sectors START...START + CNT - 1 to the extent index,
+   merging with neighboring extents. */
+static void
+extents_release (block_sector_t start, size_t cnt)
+{
+  struct free_extent *prev = extent_floor (start);
+  struct free_extent *next = extent_ceiling (start);
+  struct free_extent *e;
+
+  if (prev != NULL && prev->start + prev->cnt == start)
+    {
+      prev->cnt += cnt;
+      if (next != NULL && start + cnt == next->start)
+        {
+          prev->cnt += next->cnt;
+          extent_root = extent_remove (extent_root, next);
+          free (next);
+        }
+      extent_refresh (extent_root, prev);
+    }
+  else if (next != NULL && start + cnt == next->start)
+    {
+      next->start = start;
+      next->cnt += cnt;
+      extent_refresh (extent_root, next);
+    }
+  else
+    {
+      /* If we can't get memory for a new extent, the sectors are
+         still marked free in the bitmap; the next allocation that
+         fails will rebuild the index and find them again. */
+      e = malloc (sizeof *e);
+      if (e == NULL)
+        {
+          extents_lost = true;
+          return;
+        }
+      e->start = start;
+      e->cnt = cnt;
+      extent_root = extent_insert (extent_root, e);
+    }
 }
 
 /* Allocates CNT consecutive sectors from the free map and stores
@@ -27,16 +439,45 @@ free_map_init (void)
 bool
 free_map_allocate (size_t cnt, block_sector_t *sectorp)
 {
-  block_sector_t sector = bitmap_scan_and_flip (free_map, 0, cnt, false);
-  if (sector != BITMAP_ERROR
-      && free_map_file != NULL
-      && !bitmap_write (free_map, free_map_file))
+  return free_map_allocate_near (cnt, next_fit, sectorp);
+}
+
+/* Like free_map_allocate(), but prefers the first run of CNT
+   free sectors at or after HINT, so that related data (e.g. a
+   file's consecutive sectors, or a file and its directory) ends
+   up close together on disk. */
+bool
+free_map_allocate_near (size_t cnt, block_sector_t hint,
+                        block_sector_t *sectorp)
+{
+  block_sector_t sector;
+
+  lock_acquire (&free_map_lock);
+  sector = extents_allocate (cnt, hint);
+  if (sector == BITMAP_ERROR && extents_lost)
     {
-      bitmap_set_multiple (free_map, sector, cnt, false); 
-      sector = BITMAP_ERROR;
+      /* The index lost track of some free sectors when memory ran
+         out in extents_release(). */
+      extents_rebuild ();
+      sector = extents_allocate (cnt, hint);
     }
   if (sector != BITMAP_ERROR)
-    *sectorp = sector;
+    {
+      ASSERT (bitmap_none (free_map, sector, cnt));
+      bitmap_set_multiple (free_map, sector, cnt, true);
+      if (free_map_file != NULL && !bitmap_write (free_map, free_map_file))
+        {
+          bitmap_set_multiple (free_map, sector, cnt, false);
+          extents_release (sector, cnt);
+          sector = BITMAP_ERROR;
+        }
+    }
+  if (sector != BITMAP_ERROR)
+    {
+      next_fit = sector + cnt;
+      *sectorp = sector;
+    }
+  lock_release (&free_map_lock);
   return sector != BITMAP_ERROR;
 }
 
@@ -44,9 +485,12 @@ free_map_allocate (size_t cnt, block_sector_t *sectorp)
 void
 free_map_release (block_sector_t sector, size_t cnt)
 {
+  lock_acquire (&free_map_lock);
   ASSERT (bitmap_all (free_map, sector, cnt));
   bitmap_set_multiple (free_map, sector, cnt, false);
+  extents_release (sector, cnt);
   bitmap_write (free_map, free_map_file);
+  lock_release (&free_map_lock);
 }
 
 /* Opens the free map file and reads it from disk. */
@@ -58,6 +502,7 @@ free_map_open (void)
     PANIC ("can't open free map");
   if (!bitmap_read (free_map, free_map_file))
     PANIC ("can't read free map");
+  extents_rebuild ();
 }
 
 /* Writes the free map to disk and closes the free map file. */
@@ -73,7 +518,7 @@ void
 free_map_create (void) 
 {
   /* Create inode. */
-  if (!inode_create (FREE_MAP_SECTOR, bitmap_file_size (free_map)))
+  if (!inode_create (FREE_MAP_SECTOR, bitmap_file_size (free_map), false))
     PANIC ("free map creation failed");
 
   /* Write bitmap to file. */
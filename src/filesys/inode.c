@@ -1,23 +1,46 @@
 #include "filesys/inode.h"
-#include <list.h>
+#include <hash.h>
 #include <debug.h>
 #include <round.h>
+#include <stdio.h>
 #include <string.h>
+#include "filesys/cache.h"
 #include "filesys/filesys.h"
 #include "filesys/free-map.h"
 #include "threads/malloc.h"
+#include "threads/synch.h"
 
 /* Identifies an inode. */
 #define INODE_MAGIC 0x494e4f44
 
+/* Number of sector pointers held directly in the on-disk inode,
+   and in one index block. */
+#define DIRECT_CNT 123
+#define INDIRECT_CNT (BLOCK_SECTOR_SIZE / sizeof (block_sector_t))
+
+/* Number of data sectors reachable through the direct pointers,
+   the indirect block, and the doubly indirect block. */
+#define DIRECT_SECTORS DIRECT_CNT
+#define INDIRECT_SECTORS INDIRECT_CNT
+#define DBL_INDIRECT_SECTORS (INDIRECT_CNT * INDIRECT_CNT)
+
+/* Largest file an inode can describe, in sectors. */
+#define MAX_FILE_SECTORS \
+  (DIRECT_SECTORS + INDIRECT_SECTORS + DBL_INDIRECT_SECTORS)
+
 /* On-disk inode.
-   Must be exactly BLOCK_SECTOR_SIZE bytes long. */
+   Must be exactly BLOCK_SECTOR_SIZE bytes long.
+   A sector pointer of 0 means "not allocated": sector 0 holds the
+   free map inode, so it is never a data or index sector.  Reads
+   from unallocated sectors return zeros. */
 struct inode_disk
   {
-    block_sector_t start;               /* First data sector. */
+    block_sector_t direct[DIRECT_CNT];  /* Direct data sectors. */
+    block_sector_t indirect;            /* Index block of data sectors. */
+    block_sector_t dbl_indirect;        /* Index block of index blocks. */
     off_t length;                       /* File size in bytes. */
     unsigned magic;                     /* Magic number. */
-    uint32_t unused[125];               /* Not used. */
+    uint32_t is_dir;                    /* Nonzero if a directory. */
   };
 
 /* Returns the number of sectors to allocate for an inode SIZE
@@ -31,49 +54,272 @@ bytes_to_sectors (off_t size)
 /* In-memory inode. */
 struct inode 
   {
-    struct list_elem elem;              /* Element in inode list. */
+    struct hash_elem elem;              /* Element in open_inodes. */
     block_sector_t sector;              /* Sector number of disk location. */
     int open_cnt;                       /* Number of openers. */
     bool removed;                       /* True if deleted, false otherwise. */
     int deny_write_cnt;                 /* 0: writes ok, >0: deny writes. */
     struct inode_disk data;             /* Inode content. */
+    block_sector_t alloc_hint;          /* Where to look for new sectors. */
+    struct rwlock rw;                   /* Readers share, writers don't. */
+    struct lock dir_lock;               /* Serializes directory updates. */
+
+    /* Copy of the last index block that mapped data sectors,
+       so that sequential access skips the walk down the tree.
+       Concurrent readers all update it, so it has its own lock. */
+    struct lock index_lock;             /* Protects the members below. */
+    block_sector_t index_sector;        /* Index block held, 0 if none. */
+    size_t index_base;                  /* First file sector it maps. */
+    block_sector_t index[INDIRECT_CNT]; /* Its contents. */
   };
 
+/* Allocates a sector for INODE, zeroes it, and stores it in
+   *SECTORP.  Tries to place it right after the sector INODE got
+   last, so that files written sequentially stay contiguous.
+   Returns true if successful, false if the disk is full. */
+static bool
+allocate_zeroed (struct inode *inode, block_sector_t *sectorp)
+{
+  static char zeros[BLOCK_SECTOR_SIZE];
+
+  if (!free_map_allocate_near (1, inode->alloc_hint, sectorp))
+    return false;
+  inode->alloc_hint = *sectorp + 1;
+  cache_write (*sectorp, zeros, 0, BLOCK_SECTOR_SIZE);
+  return true;
+}
+
+/* Returns the sector in *SLOT, a pointer inside INODE's on-disk
+   inode.  If *SLOT is empty and CREATE is true, first allocates
+   a zeroed sector for it and writes the inode back.
+   Returns 0 if the slot is still empty. */
+static block_sector_t
+disk_slot (struct inode *inode, block_sector_t *slot, bool create)
+{
+  if (*slot == 0 && create && allocate_zeroed (inode, slot))
+    cache_write (inode->sector, &inode->data, 0, BLOCK_SECTOR_SIZE);
+  return *slot;
+}
+
+/* Returns entry IDX of INODE's index block SECTOR, as
+   disk_slot(). */
+static block_sector_t
+index_slot (struct inode *inode, block_sector_t sector, size_t idx,
+            bool create)
+{
+  block_sector_t slot;
+
+  cache_read (sector, &slot, idx * sizeof slot, sizeof slot);
+  if (slot == 0 && create && allocate_zeroed (inode, &slot))
+    cache_write (sector, &slot, idx * sizeof slot, sizeof slot);
+  return slot;
+}
+
+/* Returns the index block that maps file sector IDX, which must
+   lie past the direct pointers, and stores the first file sector
+   that the block maps into *BASEP.  Allocates missing index
+   blocks if CREATE is true.  Returns 0 if there is no such
+   block. */
+static block_sector_t
+find_index_block (struct inode *inode, size_t idx, size_t *basep,
+                  bool create)
+{
+  block_sector_t dbl;
+
+  idx -= DIRECT_SECTORS;
+  if (idx < INDIRECT_SECTORS)
+    {
+      *basep = DIRECT_SECTORS;
+      return disk_slot (inode, &inode->data.indirect, create);
+    }
+
+  idx -= INDIRECT_SECTORS;
+  *basep = DIRECT_SECTORS + INDIRECT_SECTORS
+           + idx / INDIRECT_CNT * INDIRECT_CNT;
+  dbl = disk_slot (inode, &inode->data.dbl_indirect, create);
+  if (dbl == 0)
+    return 0;
+  return index_slot (inode, dbl, idx / INDIRECT_CNT, create);
+}
+
 /* Returns the block device sector that contains byte offset POS
    within INODE.
-   Returns -1 if INODE does not contain data for a byte at offset
-   POS. */
+   If that sector has not been allocated yet, allocates a zeroed
+   sector for it if CREATE is true.  Returns 0 if INODE has no
+   sector for POS, either because it is a hole or because POS is
+   beyond the largest possible file. */
 static block_sector_t
-byte_to_sector (const struct inode *inode, off_t pos) 
+byte_to_sector (struct inode *inode, off_t pos, bool create) 
 {
+  size_t idx = pos / BLOCK_SECTOR_SIZE;
+  block_sector_t sector = 0;
+  block_sector_t index_sector, *slot;
+  size_t base;
+
   ASSERT (inode != NULL);
-  if (pos < inode->data.length)
-    return inode->data.start + pos / BLOCK_SECTOR_SIZE;
-  else
-    return -1;
+  ASSERT (pos >= 0);
+
+  lock_acquire (&inode->index_lock);
+  if (idx < DIRECT_SECTORS)
+    {
+      sector = disk_slot (inode, &inode->data.direct[idx], create);
+      goto done;
+    }
+  if (idx >= MAX_FILE_SECTORS)
+    goto done;
+
+  /* Bring the index block that maps IDX into the per-inode copy,
+     unless it is already there. */
+  if (inode->index_sector == 0
+      || idx < inode->index_base
+      || idx >= inode->index_base + INDIRECT_CNT)
+    {
+      index_sector = find_index_block (inode, idx, &base, create);
+      if (index_sector == 0)
+        goto done;
+      cache_read (index_sector, inode->index, 0, BLOCK_SECTOR_SIZE);
+      inode->index_sector = index_sector;
+      inode->index_base = base;
+    }
+
+  slot = &inode->index[idx - inode->index_base];
+  if (*slot == 0 && create && allocate_zeroed (inode, slot))
+    cache_write (inode->index_sector, slot,
+                 (idx - inode->index_base) * sizeof *slot, sizeof *slot);
+  sector = *slot;
+
+ done:
+  lock_release (&inode->index_lock);
+  return sector;
 }
 
-/* List of open inodes, so that opening a single inode twice
-   returns the same `struct inode'. */
-static struct list open_inodes;
+/* Frees SECTOR, which is an index block of the given LEVEL (0
+   for a data sector, 1 for an indirect block, 2 for a doubly
+   indirect block), along with every sector it refers to. */
+static void
+release_sectors (block_sector_t sector, int level)
+{
+  if (sector == 0)
+    return;
+
+  if (level > 0)
+    {
+      size_t i;
+
+      /* Read the entries one at a time through the cache rather
+         than allocating a buffer, which could fail and leak every
+         sector below this one. */
+      for (i = 0; i < INDIRECT_CNT; i++)
+        {
+          block_sector_t entry;
+
+          cache_read (sector, &entry, i * sizeof entry, sizeof entry);
+          release_sectors (entry, level - 1);
+        }
+    }
+  free_map_release (sector, 1);
+}
+
+/* Frees all of INODE's data and index sectors. */
+static void
+inode_release (struct inode *inode)
+{
+  size_t i;
+
+  for (i = 0; i < DIRECT_CNT; i++)
+    release_sectors (inode->data.direct[i], 0);
+  release_sectors (inode->data.indirect, 1);
+  release_sectors (inode->data.dbl_indirect, 2);
+}
+
+/* Table of open inodes, keyed by sector, so that opening a
+   single inode twice returns the same `struct inode'.
+   open_inodes_lock protects the table and every inode's
+   open_cnt; it is never held across disk I/O. */
+static struct hash open_inodes;
+static struct lock open_inodes_lock;
+
+/* Profiling counters for inode_open(), protected by
+   open_inodes_lock. */
+static unsigned long long open_lookup_cnt;  /* Calls to inode_open(). */
+static unsigned long long open_hit_cnt;     /* Found already open. */
+
+static hash_hash_func inode_hash;
+static hash_less_func inode_less;
 
 /* Initializes the inode module. */
 void
 inode_init (void) 
 {
-  list_init (&open_inodes);
+  hash_init (&open_inodes, inode_hash, inode_less, NULL);
+  lock_init (&open_inodes_lock);
+}
+
+/* Returns a hash value for the inode that E refers to. */
+static unsigned
+inode_hash (const struct hash_elem *e, void *aux UNUSED)
+{
+  const struct inode *inode = hash_entry (e, struct inode, elem);
+  return hash_int (inode->sector);
+}
+
+/* Returns true if inode A's sector precedes inode B's. */
+static bool
+inode_less (const struct hash_elem *a_, const struct hash_elem *b_,
+            void *aux UNUSED)
+{
+  const struct inode *a = hash_entry (a_, struct inode, elem);
+  const struct inode *b = hash_entry (b_, struct inode, elem);
+  return a->sector < b->sector;
+}
+
+/* Looks up the open inode for SECTOR and, if there is one,
+   reopens and returns it.  Otherwise returns a null pointer.
+   open_inodes_lock must be held. */
+static struct inode *
+open_inodes_find (block_sector_t sector)
+{
+  /* Too big for the kernel stack; open_inodes_lock serializes
+     its use. */
+  static struct inode key;
+  struct inode *inode;
+  struct hash_elem *e;
+
+  ASSERT (lock_held_by_current_thread (&open_inodes_lock));
+
+  key.sector = sector;
+  e = hash_find (&open_inodes, &key.elem);
+  if (e == NULL)
+    return NULL;
+
+  open_hit_cnt++;
+  inode = hash_entry (e, struct inode, elem);
+  inode->open_cnt++;
+  return inode;
+}
+
+/* Prints inode_open() statistics. */
+void
+inode_print_stats (void)
+{
+  printf ("Inodes: %llu opens, %llu found already open\n",
+          open_lookup_cnt, open_hit_cnt);
 }
 
 /* Initializes an inode with LENGTH bytes of data and
    writes the new inode to sector SECTOR on the file system
-   device.
+   device.  The data sectors are allocated up front and zeroed;
+   later writes past the end of file grow the inode on demand.
+   IS_DIR marks the inode as holding a directory.
    Returns true if successful.
    Returns false if memory or disk allocation fails. */
 bool
-inode_create (block_sector_t sector, off_t length)
+inode_create (block_sector_t sector, off_t length, bool is_dir)
 {
   struct inode_disk *disk_inode = NULL;
-  bool success = false;
+  struct inode *inode;
+  bool success = true;
+  size_t sectors, i;
 
   ASSERT (length >= 0);
 
@@ -81,27 +327,27 @@ inode_create (block_sector_t sector, off_t length)
      one sector in size, and you should fix that. */
   ASSERT (sizeof *disk_inode == BLOCK_SECTOR_SIZE);
 
+  sectors = bytes_to_sectors (length);
+  if (sectors > MAX_FILE_SECTORS)
+    return false;
+
   disk_inode = calloc (1, sizeof *disk_inode);
-  if (disk_inode != NULL)
-    {
-      size_t sectors = bytes_to_sectors (length);
-      disk_inode->length = length;
-      disk_inode->magic = INODE_MAGIC;
-      if (free_map_allocate (sectors, &disk_inode->start)) 
-        {
-          block_write (fs_device, sector, disk_inode);
-          if (sectors > 0) 
-            {
-              static char zeros[BLOCK_SECTOR_SIZE];
-              size_t i;
-              
-              for (i = 0; i < sectors; i++) 
-                block_write (fs_device, disk_inode->start + i, zeros);
-            }
-          success = true; 
-        } 
-      free (disk_inode);
-    }
+  if (disk_inode == NULL)
+    return false;
+  disk_inode->length = length;
+  disk_inode->magic = INODE_MAGIC;
+  disk_inode->is_dir = is_dir;
+  cache_write (sector, disk_inode, 0, BLOCK_SECTOR_SIZE);
+  free (disk_inode);
+
+  inode = inode_open (sector);
+  if (inode == NULL)
+    return false;
+  for (i = 0; i < sectors && success; i++)
+    success = byte_to_sector (inode, i * BLOCK_SECTOR_SIZE, true) != 0;
+  if (!success)
+    inode_release (inode);
+  inode_close (inode);
   return success;
 }
 
@@ -111,33 +357,45 @@ inode_create (block_sector_t sector, off_t length)
 struct inode *
 inode_open (block_sector_t sector)
 {
-  struct list_elem *e;
-  struct inode *inode;
+  struct inode *inode, *found;
 
   /* Check whether this inode is already open. */
-  for (e = list_begin (&open_inodes); e != list_end (&open_inodes);
-       e = list_next (e)) 
-    {
-      inode = list_entry (e, struct inode, elem);
-      if (inode->sector == sector) 
-        {
-          inode_reopen (inode);
-          return inode; 
-        }
-    }
+  lock_acquire (&open_inodes_lock);
+  open_lookup_cnt++;
+  inode = open_inodes_find (sector);
+  lock_release (&open_inodes_lock);
+  if (inode != NULL)
+    return inode;
 
   /* Allocate memory. */
   inode = malloc (sizeof *inode);
   if (inode == NULL)
     return NULL;
 
-  /* Initialize. */
-  list_push_front (&open_inodes, &inode->elem);
+  /* Initialize.  We read the inode without holding the table
+     lock, so another thread may have opened the same sector in
+     the meantime; if so, use its inode instead of ours. */
   inode->sector = sector;
   inode->open_cnt = 1;
   inode->deny_write_cnt = 0;
   inode->removed = false;
-  block_read (fs_device, inode->sector, &inode->data);
+  inode->alloc_hint = sector + 1;
+  rwlock_init (&inode->rw);
+  lock_init (&inode->dir_lock);
+  lock_init (&inode->index_lock);
+  inode->index_sector = 0;
+  cache_read (inode->sector, &inode->data, 0, BLOCK_SECTOR_SIZE);
+
+  lock_acquire (&open_inodes_lock);
+  found = open_inodes_find (sector);
+  if (found == NULL)
+    hash_insert (&open_inodes, &inode->elem);
+  lock_release (&open_inodes_lock);
+  if (found != NULL)
+    {
+      free (inode);
+      return found;
+    }
   return inode;
 }
 
@@ -146,7 +404,11 @@ struct inode *
 inode_reopen (struct inode *inode)
 {
   if (inode != NULL)
-    inode->open_cnt++;
+    {
+      lock_acquire (&open_inodes_lock);
+      inode->open_cnt++;
+      lock_release (&open_inodes_lock);
+    }
   return inode;
 }
 
@@ -163,22 +425,26 @@ inode_get_inumber (const struct inode *inode)
 void
 inode_close (struct inode *inode) 
 {
+  bool last;
+
   /* Ignore null pointer. */
   if (inode == NULL)
     return;
 
   /* Release resources if this was the last opener. */
-  if (--inode->open_cnt == 0)
+  lock_acquire (&open_inodes_lock);
+  last = --inode->open_cnt == 0;
+  if (last)
+    hash_delete (&open_inodes, &inode->elem);
+  lock_release (&open_inodes_lock);
+
+  if (last)
     {
-      /* Remove from inode list and release lock. */
-      list_remove (&inode->elem);
- 
       /* Deallocate blocks if removed. */
       if (inode->removed) 
         {
           free_map_release (inode->sector, 1);
-          free_map_release (inode->data.start,
-                            bytes_to_sectors (inode->data.length)); 
+          inode_release (inode);
         }
 
       free (inode); 
@@ -194,6 +460,21 @@ inode_remove (struct inode *inode)
   inode->removed = true;
 }
 
+/* Returns true if INODE has been removed, even though it may
+   still be open. */
+bool
+inode_is_removed (const struct inode *inode)
+{
+  return inode->removed;
+}
+
+/* Returns true if INODE holds a directory. */
+bool
+inode_is_dir (const struct inode *inode)
+{
+  return inode->data.is_dir != 0;
+}
+
 /* Reads SIZE bytes from INODE into BUFFER, starting at position OFFSET.
    Returns the number of bytes actually read, which may be less
    than SIZE if an error occurs or end of file is reached. */
@@ -202,13 +483,13 @@ inode_read_at (struct inode *inode, void *buffer_, off_t size, off_t offset)
 {
   uint8_t *buffer = buffer_;
   off_t bytes_read = 0;
-  uint8_t *bounce = NULL;
 
+  rwlock_acquire_read (&inode->rw);
   while (size > 0) 
     {
       /* Disk sector to read, starting byte offset within sector. */
-      block_sector_t sector_idx = byte_to_sector (inode, offset);
       int sector_ofs = offset % BLOCK_SECTOR_SIZE;
+      block_sector_t sector_idx;
 
       /* Bytes left in inode, bytes left in sector, lesser of the two. */
       off_t inode_left = inode_length (inode) - offset;
@@ -220,99 +501,87 @@ inode_read_at (struct inode *inode, void *buffer_, off_t size, off_t offset)
       if (chunk_size <= 0)
         break;
 
-      if (sector_ofs == 0 && chunk_size == BLOCK_SECTOR_SIZE)
-        {
-          /* Read full sector directly into caller's buffer. */
-          block_read (fs_device, sector_idx, buffer + bytes_read);
-        }
-      else 
-        {
-          /* Read sector into bounce buffer, then partially copy
-             into caller's buffer. */
-          if (bounce == NULL) 
-            {
-              bounce = malloc (BLOCK_SECTOR_SIZE);
-              if (bounce == NULL)
-                break;
-            }
-          block_read (fs_device, sector_idx, bounce);
-          memcpy (buffer + bytes_read, bounce + sector_ofs, chunk_size);
-        }
+      /* Copy the chunk out of the buffer cache.  Holes in a
+         sparse file read as zeros. */
+      sector_idx = byte_to_sector (inode, offset, false);
+      if (sector_idx != 0)
+        cache_read (sector_idx, buffer + bytes_read, sector_ofs, chunk_size);
+      else
+        memset (buffer + bytes_read, 0, chunk_size);
       
       /* Advance. */
       size -= chunk_size;
       offset += chunk_size;
       bytes_read += chunk_size;
     }
-  free (bounce);
+
+  /* Start fetching the sector after the last one read, on the
+     guess that the caller is reading sequentially. */
+  if (bytes_read > 0)
+    {
+      off_t next = ROUND_UP (offset, BLOCK_SECTOR_SIZE);
+      block_sector_t next_sector;
+
+      if (next < inode_length (inode)
+          && (next_sector = byte_to_sector (inode, next, false)) != 0)
+        cache_readahead (next_sector);
+    }
+  rwlock_release_read (&inode->rw);
 
   return bytes_read;
 }
 
 /* Writes SIZE bytes from BUFFER into INODE, starting at OFFSET.
    Returns the number of bytes actually written, which may be
-   less than SIZE if end of file is reached or an error occurs.
-   (Normally a write at end of file would extend the inode, but
-   growth is not yet implemented.) */
+   less than SIZE if the disk fills up, the file reaches its
+   maximum size, or an error occurs.
+   Writing past end of file extends the inode.  Sectors between
+   the old end of file and OFFSET are left unallocated and read
+   back as zeros. */
 off_t
 inode_write_at (struct inode *inode, const void *buffer_, off_t size,
                 off_t offset) 
 {
   const uint8_t *buffer = buffer_;
   off_t bytes_written = 0;
-  uint8_t *bounce = NULL;
 
+  rwlock_acquire_write (&inode->rw);
   if (inode->deny_write_cnt)
-    return 0;
+    {
+      rwlock_release_write (&inode->rw);
+      return 0;
+    }
 
   while (size > 0) 
     {
-      /* Sector to write, starting byte offset within sector. */
-      block_sector_t sector_idx = byte_to_sector (inode, offset);
+      /* Sector to write, allocating it if necessary, and
+         starting byte offset within sector. */
+      block_sector_t sector_idx = byte_to_sector (inode, offset, true);
       int sector_ofs = offset % BLOCK_SECTOR_SIZE;
 
-      /* Bytes left in inode, bytes left in sector, lesser of the two. */
-      off_t inode_left = inode_length (inode) - offset;
-      int sector_left = BLOCK_SECTOR_SIZE - sector_ofs;
-      int min_left = inode_left < sector_left ? inode_left : sector_left;
-
       /* Number of bytes to actually write into this sector. */
-      int chunk_size = size < min_left ? size : min_left;
-      if (chunk_size <= 0)
+      int sector_left = BLOCK_SECTOR_SIZE - sector_ofs;
+      int chunk_size = size < sector_left ? size : sector_left;
+      if (sector_idx == 0)
         break;
 
-      if (sector_ofs == 0 && chunk_size == BLOCK_SECTOR_SIZE)
-        {
-          /* Write full sector directly to disk. */
-          block_write (fs_device, sector_idx, buffer + bytes_written);
-        }
-      else 
-        {
-          /* We need a bounce buffer. */
-          if (bounce == NULL) 
-            {
-              bounce = malloc (BLOCK_SECTOR_SIZE);
-              if (bounce == NULL)
-                break;
-            }
-
-          /* If the sector contains data before or after the chunk
-             we're writing, then we need to read in the sector
-             first.  Otherwise we start with a sector of all zeros. */
-          if (sector_ofs > 0 || chunk_size < sector_left) 
-            block_read (fs_device, sector_idx, bounce);
-          else
-            memset (bounce, 0, BLOCK_SECTOR_SIZE);
-          memcpy (bounce + sector_ofs, buffer + bytes_written, chunk_size);
-          block_write (fs_device, sector_idx, bounce);
-        }
+      /* Copy the chunk into the buffer cache, which reads in the
+         rest of the sector first if we only cover part of it. */
+      cache_write (sector_idx, buffer + bytes_written, sector_ofs, chunk_size);
 
       /* Advance. */
       size -= chunk_size;
       offset += chunk_size;
       bytes_written += chunk_size;
     }
-  free (bounce);
+
+  /* Extend the file if we wrote past its end. */
+  if (bytes_written > 0 && offset > inode->data.length)
+    {
+      inode->data.length = offset;
+      cache_write (inode->sector, &inode->data, 0, BLOCK_SECTOR_SIZE);
+    }
+  rwlock_release_write (&inode->rw);
 
   return bytes_written;
 }
@@ -322,8 +591,10 @@ inode_write_at (struct inode *inode, const void *buffer_, off_t size,
 void
 inode_deny_write (struct inode *inode) 
 {
+  rwlock_acquire_write (&inode->rw);
   inode->deny_write_cnt++;
   ASSERT (inode->deny_write_cnt <= inode->open_cnt);
+  rwlock_release_write (&inode->rw);
 }
 
 /* Re-enables writes to INODE.
@@ -332,9 +603,27 @@ inode_deny_write (struct inode *inode)
 void
 inode_allow_write (struct inode *inode) 
 {
+  rwlock_acquire_write (&inode->rw);
   ASSERT (inode->deny_write_cnt > 0);
   ASSERT (inode->deny_write_cnt <= inode->open_cnt);
   inode->deny_write_cnt--;
+  rwlock_release_write (&inode->rw);
+}
+
+/* Acquires INODE's directory lock.  Directory code holds it
+   whenever it reads or changes INODE's entries, because adding
+   an entry may rebuild the directory's whole hash table. */
+void
+inode_lock_dir (struct inode *inode) 
+{
+  lock_acquire (&inode->dir_lock);
+}
+
+/* Releases INODE's directory lock. */
+void
+inode_unlock_dir (struct inode *inode) 
+{
+  lock_release (&inode->dir_lock);
 }
 
 /* Returns the length, in bytes, of INODE's data. */
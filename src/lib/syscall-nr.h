@@ -28,7 +28,17 @@ enum
     SYS_MKDIR,                  /* Create a directory. */
     SYS_READDIR,                /* Reads a directory entry. */
     SYS_ISDIR,                  /* Tests if a fd represents a directory. */
-    SYS_INUMBER                 /* Returns the inode number for a fd. */
+    SYS_INUMBER,                /* Returns the inode number for a fd. */
+
+    /* Extensions. */
+    SYS_MSYNC,                  /* Write back a memory mapping. */
+    SYS_PREAD,                  /* Read from a file at an offset. */
+    SYS_PWRITE,                 /* Write to a file at an offset. */
+    SYS_READV,                  /* Read into several buffers. */
+    SYS_WRITEV,                 /* Write from several buffers. */
+    SYS_RING_SETUP,             /* Register a batched syscall ring. */
+    SYS_RING_ENTER,             /* Execute queued batched syscalls. */
+    SYS_SENDFILE                /* Copy between files in the kernel. */
   };
 
 #endif /* lib/syscall-nr.h */
@@ -0,0 +1,63 @@
+#ifndef __LIB_SYSCALL_RING_H
+#define __LIB_SYSCALL_RING_H
+
+#include <stdint.h>
+
+/* Batched system calls.
+
+   A process that opts in with ring_setup() queues requests in a
+   submission queue in its own memory and then executes all of
+   them with a single ring_enter() call.  The kernel writes one
+   result per request into the completion queue.
+
+   Both queues have ENTRIES slots, a power of two.  The user
+   advances SQ_TAIL and CQ_HEAD; the kernel advances SQ_HEAD and
+   CQ_TAIL.  The indexes run freely and wrap, so a queue holds
+   TAIL - HEAD entries, at slot INDEX & (ENTRIES - 1). */
+
+/* Maximum number of slots in each queue. */
+#define RING_MAX_ENTRIES 4096
+
+/* Operations. */
+enum ring_op
+  {
+    RING_READ,                  /* read (fd, buf, len). */
+    RING_WRITE,                 /* write (fd, buf, len). */
+    RING_OPEN,                  /* open (buf), BUF a file name. */
+    RING_CLOSE,                 /* close (fd). */
+    RING_SEEK,                  /* seek (fd, offset). */
+    RING_PREAD,                 /* pread (fd, buf, len, offset). */
+    RING_PWRITE                 /* pwrite (fd, buf, len, offset). */
+  };
+
+/* A submission queue entry. */
+struct ring_sqe
+  {
+    uint32_t op;                /* One of enum ring_op. */
+    int32_t fd;                 /* File descriptor. */
+    void *buf;                  /* Buffer or file name. */
+    uint32_t len;               /* Buffer length. */
+    uint32_t offset;            /* File offset. */
+    uint32_t user_data;         /* Copied to the completion. */
+  };
+
+/* A completion queue entry. */
+struct ring_cqe
+  {
+    uint32_t user_data;         /* From the submission. */
+    int32_t result;             /* What the system call returned. */
+  };
+
+/* A pair of queues. */
+struct syscall_ring
+  {
+    uint32_t sq_head;           /* Next submission to execute. */
+    uint32_t sq_tail;           /* Next free submission slot. */
+    uint32_t cq_head;           /* Next completion to consume. */
+    uint32_t cq_tail;           /* Next free completion slot. */
+    uint32_t entries;           /* Slots in each queue. */
+    struct ring_sqe *sqes;      /* Submission queue. */
+    struct ring_cqe *cqes;      /* Completion queue. */
+  };
+
+#endif /* lib/syscall-ring.h */
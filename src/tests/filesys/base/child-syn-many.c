@@ -0,0 +1,43 @@
+/* Child process for syn-many test.
+   Streams through its own test file a chunk at a time, checking
+   each chunk as it goes. */
+
+#include <random.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/filesys/base/syn-many.h"
+
+static char buf[BUF_SIZE];
+
+int
+main (int argc, const char *argv[]) 
+{
+  char name[16];
+  int child_idx;
+  int fd;
+  size_t i;
+
+  test_name = "child-syn-many";
+  quiet = true;
+  
+  CHECK (argc == 2, "argc must be 2, actually %d", argc);
+  child_idx = atoi (argv[1]);
+  syn_many_file_name (name, child_idx);
+
+  random_init (child_idx);
+  random_bytes (buf, sizeof buf);
+
+  CHECK ((fd = open (name)) > 1, "open \"%s\"", name);
+  for (i = 0; i < sizeof buf; i += CHUNK_SIZE) 
+    {
+      char chunk[CHUNK_SIZE];
+      CHECK (read (fd, chunk, CHUNK_SIZE) == CHUNK_SIZE,
+             "read \"%s\"", name);
+      compare_bytes (chunk, buf + i, CHUNK_SIZE, i, name);
+    }
+  close (fd);
+
+  return child_idx;
+}
@@ -0,0 +1,43 @@
+/* Spawns 10 child processes, each of which streams through a
+   different file and makes sure that its contents are what they
+   should be.  The files do not fit in the buffer cache together,
+   so the children spend their time waiting for the disk.  They
+   never touch the same inode, so with per-inode locking and cache
+   I/O done outside the cache lock their reads proceed in parallel
+   instead of queuing behind one another in the kernel.  Comparing
+   the "Timer:" line of this test's output against a kernel that
+   serializes file system calls shows the difference. */
+
+#include <random.h>
+#include <stdio.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+#include "tests/filesys/base/syn-many.h"
+
+static char buf[BUF_SIZE];
+
+void
+test_main (void) 
+{
+  pid_t children[CHILD_CNT];
+  char name[16];
+  int fd;
+  int i;
+
+  for (i = 0; i < CHILD_CNT; i++) 
+    {
+      syn_many_file_name (name, i);
+      CHECK (create (name, sizeof buf), "create \"%s\"", name);
+      CHECK ((fd = open (name)) > 1, "open \"%s\"", name);
+      random_init (i);
+      random_bytes (buf, sizeof buf);
+      CHECK (write (fd, buf, sizeof buf) == sizeof buf,
+             "write \"%s\"", name);
+      msg ("close \"%s\"", name);
+      close (fd);
+    }
+
+  exec_children ("child-syn-many", children, CHILD_CNT);
+  wait_children (children, CHILD_CNT);
+}
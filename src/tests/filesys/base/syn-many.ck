@@ -0,0 +1,69 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(syn-many) begin
+(syn-many) create "data0"
+(syn-many) open "data0"
+(syn-many) write "data0"
+(syn-many) close "data0"
+(syn-many) create "data1"
+(syn-many) open "data1"
+(syn-many) write "data1"
+(syn-many) close "data1"
+(syn-many) create "data2"
+(syn-many) open "data2"
+(syn-many) write "data2"
+(syn-many) close "data2"
+(syn-many) create "data3"
+(syn-many) open "data3"
+(syn-many) write "data3"
+(syn-many) close "data3"
+(syn-many) create "data4"
+(syn-many) open "data4"
+(syn-many) write "data4"
+(syn-many) close "data4"
+(syn-many) create "data5"
+(syn-many) open "data5"
+(syn-many) write "data5"
+(syn-many) close "data5"
+(syn-many) create "data6"
+(syn-many) open "data6"
+(syn-many) write "data6"
+(syn-many) close "data6"
+(syn-many) create "data7"
+(syn-many) open "data7"
+(syn-many) write "data7"
+(syn-many) close "data7"
+(syn-many) create "data8"
+(syn-many) open "data8"
+(syn-many) write "data8"
+(syn-many) close "data8"
+(syn-many) create "data9"
+(syn-many) open "data9"
+(syn-many) write "data9"
+(syn-many) close "data9"
+(syn-many) exec child 1 of 10: "child-syn-many 0"
+(syn-many) exec child 2 of 10: "child-syn-many 1"
+(syn-many) exec child 3 of 10: "child-syn-many 2"
+(syn-many) exec child 4 of 10: "child-syn-many 3"
+(syn-many) exec child 5 of 10: "child-syn-many 4"
+(syn-many) exec child 6 of 10: "child-syn-many 5"
+(syn-many) exec child 7 of 10: "child-syn-many 6"
+(syn-many) exec child 8 of 10: "child-syn-many 7"
+(syn-many) exec child 9 of 10: "child-syn-many 8"
+(syn-many) exec child 10 of 10: "child-syn-many 9"
+(syn-many) wait for child 1 of 10 returned 0 (expected 0)
+(syn-many) wait for child 2 of 10 returned 1 (expected 1)
+(syn-many) wait for child 3 of 10 returned 2 (expected 2)
+(syn-many) wait for child 4 of 10 returned 3 (expected 3)
+(syn-many) wait for child 5 of 10 returned 4 (expected 4)
+(syn-many) wait for child 6 of 10 returned 5 (expected 5)
+(syn-many) wait for child 7 of 10 returned 6 (expected 6)
+(syn-many) wait for child 8 of 10 returned 7 (expected 7)
+(syn-many) wait for child 9 of 10 returned 8 (expected 8)
+(syn-many) wait for child 10 of 10 returned 9 (expected 9)
+(syn-many) end
+EOF
+pass;
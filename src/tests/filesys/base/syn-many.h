@@ -0,0 +1,21 @@
+#ifndef TESTS_FILESYS_BASE_SYN_MANY_H
+#define TESTS_FILESYS_BASE_SYN_MANY_H
+
+#define CHILD_CNT 10
+
+/* Size of each child's file.  Together the files are ten times
+   the size of the buffer cache, so the children keep missing in
+   it and their disk reads overlap. */
+#define BUF_SIZE (32 * 1024)
+
+/* Amount each child reads at a time. */
+#define CHUNK_SIZE 512
+
+/* Name of the file read by child IDX. */
+static inline void
+syn_many_file_name (char name[16], int idx)
+{
+  snprintf (name, 16, "data%d", idx);
+}
+
+#endif /* tests/filesys/base/syn-many.h */
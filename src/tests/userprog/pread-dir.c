@@ -0,0 +1,16 @@
+/* Tries to pread() from a directory, which must fail. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  int handle;
+  char buf[16];
+
+  CHECK (mkdir ("a"), "mkdir \"a\"");
+  CHECK ((handle = open ("a")) > 1, "open \"a\"");
+  CHECK (pread (handle, buf, sizeof buf, 0) == -1, "pread \"a\" (must fail)");
+}
@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(pread-dir) begin
+(pread-dir) mkdir "a"
+(pread-dir) open "a"
+(pread-dir) pread "a" (must fail)
+(pread-dir) end
+pread-dir: exit(0)
+EOF
+pass;
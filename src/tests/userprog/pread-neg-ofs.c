@@ -0,0 +1,22 @@
+/* Passes a negative offset to pread(), which must fail
+   without reading anything. */
+
+#include <limits.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  int handle;
+  char buf = 123;
+
+  CHECK ((handle = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  CHECK (pread (handle, &buf, 1, -1) == -1, "pread at offset -1");
+  CHECK (pread (handle, &buf, 1, INT_MIN) == -1, "pread at offset INT_MIN");
+  if (buf != 123)
+    fail ("failed pread() modified buffer");
+  if (tell (handle) != 0)
+    fail ("failed pread() moved file position to %u", tell (handle));
+}
@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(pread-neg-ofs) begin
+(pread-neg-ofs) open "sample.txt"
+(pread-neg-ofs) pread at offset -1
+(pread-neg-ofs) pread at offset INT_MIN
+(pread-neg-ofs) end
+pread-neg-ofs: exit(0)
+EOF
+pass;
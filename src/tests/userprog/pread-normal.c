@@ -0,0 +1,31 @@
+/* Reads from the middle and the end of a file with pread(),
+   which must not move the file position. */
+
+#include <syscall.h>
+#include "tests/userprog/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  char buf[64];
+  int handle, byte_cnt;
+
+  CHECK ((handle = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  seek (handle, 5);
+
+  byte_cnt = pread (handle, buf, sizeof buf, 100);
+  if (byte_cnt != sizeof buf)
+    fail ("pread() returned %d instead of %zu", byte_cnt, sizeof buf);
+  compare_bytes (buf, sample + 100, sizeof buf, 100, "sample.txt");
+
+  byte_cnt = pread (handle, buf, sizeof buf, sizeof sample - 11);
+  if (byte_cnt != 10)
+    fail ("pread() at end of file returned %d instead of 10", byte_cnt);
+  compare_bytes (buf, sample + sizeof sample - 11, 10, sizeof sample - 11,
+                 "sample.txt");
+
+  if (tell (handle) != 5)
+    fail ("pread() moved file position from 5 to %u", tell (handle));
+}
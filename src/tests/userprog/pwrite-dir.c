@@ -0,0 +1,17 @@
+/* Tries to pwrite() to a directory, which must fail. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  int handle;
+  char buf[16] = "0123456789abcde";
+
+  CHECK (mkdir ("a"), "mkdir \"a\"");
+  CHECK ((handle = open ("a")) > 1, "open \"a\"");
+  CHECK (pwrite (handle, buf, sizeof buf, 0) == -1,
+         "pwrite \"a\" (must fail)");
+}
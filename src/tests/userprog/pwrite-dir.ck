@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(pwrite-dir) begin
+(pwrite-dir) mkdir "a"
+(pwrite-dir) open "a"
+(pwrite-dir) pwrite "a" (must fail)
+(pwrite-dir) end
+pwrite-dir: exit(0)
+EOF
+pass;
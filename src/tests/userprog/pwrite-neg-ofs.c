@@ -0,0 +1,23 @@
+/* Passes a negative offset to pwrite(), which must fail
+   without writing anything. */
+
+#include <limits.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  int handle;
+  char buf = 123;
+
+  CHECK (create ("test.txt", 0), "create \"test.txt\"");
+  CHECK ((handle = open ("test.txt")) > 1, "open \"test.txt\"");
+  CHECK (pwrite (handle, &buf, 1, -1) == -1, "pwrite at offset -1");
+  CHECK (pwrite (handle, &buf, 1, INT_MIN) == -1, "pwrite at offset INT_MIN");
+  if (filesize (handle) != 0)
+    fail ("failed pwrite() changed file size to %d", filesize (handle));
+  if (tell (handle) != 0)
+    fail ("failed pwrite() moved file position to %u", tell (handle));
+}
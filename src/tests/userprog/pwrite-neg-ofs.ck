@@ -0,0 +1,14 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(pwrite-neg-ofs) begin
+(pwrite-neg-ofs) create "test.txt"
+(pwrite-neg-ofs) open "test.txt"
+(pwrite-neg-ofs) pwrite at offset -1
+(pwrite-neg-ofs) pwrite at offset INT_MIN
+(pwrite-neg-ofs) end
+pwrite-neg-ofs: exit(0)
+EOF
+pass;
@@ -0,0 +1,31 @@
+/* Writes to the middle of a file with pwrite(), which must not
+   move the file position, and checks the file's contents. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/userprog/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  char expected[sizeof sample - 1];
+  int handle, byte_cnt;
+
+  CHECK (create ("test.txt", sizeof sample - 1), "create \"test.txt\"");
+  CHECK ((handle = open ("test.txt")) > 1, "open \"test.txt\"");
+  seek (handle, 10);
+
+  byte_cnt = pwrite (handle, sample + 50, 100, 50);
+  if (byte_cnt != 100)
+    fail ("pwrite() returned %d instead of 100", byte_cnt);
+  if (tell (handle) != 10)
+    fail ("pwrite() moved file position from 10 to %u", tell (handle));
+  msg ("close \"test.txt\"");
+  close (handle);
+
+  memset (expected, 0, sizeof expected);
+  memcpy (expected + 50, sample + 50, 100);
+  check_file ("test.txt", expected, sizeof expected);
+}
@@ -0,0 +1,34 @@
+/* Passes readv() a buffer count of 0, a negative count, a
+   count above IOV_MAX, and buffers whose total length does not
+   fit in an int.  The first must return 0, the others -1, and
+   none may move the file position. */
+
+#include <limits.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  static char buf[16];
+  struct iovec iov[2];
+  int handle;
+
+  iov[0].iov_base = buf;
+  iov[0].iov_len = sizeof buf;
+  iov[1].iov_base = buf;
+  iov[1].iov_len = sizeof buf;
+
+  CHECK ((handle = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  CHECK (readv (handle, iov, 0) == 0, "readv 0 buffers");
+  CHECK (readv (handle, iov, -1) == -1, "readv -1 buffers");
+  CHECK (readv (handle, iov, IOV_MAX + 1) == -1, "readv IOV_MAX + 1 buffers");
+
+  iov[0].iov_len = INT_MAX / 2 + 1;
+  iov[1].iov_len = INT_MAX / 2 + 1;
+  CHECK (readv (handle, iov, 2) == -1, "readv more than INT_MAX bytes");
+
+  if (tell (handle) != 0)
+    fail ("failed readv() moved file position to %u", tell (handle));
+}
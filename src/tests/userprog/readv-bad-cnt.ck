@@ -0,0 +1,15 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(readv-bad-cnt) begin
+(readv-bad-cnt) open "sample.txt"
+(readv-bad-cnt) readv 0 buffers
+(readv-bad-cnt) readv -1 buffers
+(readv-bad-cnt) readv IOV_MAX + 1 buffers
+(readv-bad-cnt) readv more than INT_MAX bytes
+(readv-bad-cnt) end
+readv-bad-cnt: exit(0)
+EOF
+pass;
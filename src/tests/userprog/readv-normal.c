@@ -0,0 +1,30 @@
+/* Reads a whole file into three buffers with one readv(). */
+
+#include <syscall.h>
+#include "tests/userprog/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  char buf[sizeof sample - 1];
+  struct iovec iov[3];
+  int handle, byte_cnt;
+
+  iov[0].iov_base = buf;
+  iov[0].iov_len = 100;
+  iov[1].iov_base = buf + 100;
+  iov[1].iov_len = 1;
+  iov[2].iov_base = buf + 101;
+  iov[2].iov_len = sizeof buf - 101;
+
+  CHECK ((handle = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  byte_cnt = readv (handle, iov, 3);
+  if (byte_cnt != sizeof buf)
+    fail ("readv() returned %d instead of %zu", byte_cnt, sizeof buf);
+  compare_bytes (buf, sample, sizeof buf, 0, "sample.txt");
+  if (tell (handle) != sizeof buf)
+    fail ("file position is %u after readv() instead of %zu",
+          tell (handle), sizeof buf);
+}
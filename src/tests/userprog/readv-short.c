@@ -0,0 +1,35 @@
+/* Passes readv() more buffer space than the file holds.  It
+   must stop at the first buffer that is not filled and leave
+   the buffers after it alone. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/userprog/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  char buf[sizeof sample - 1 + 100];
+  char rest[50], zeros[50];
+  struct iovec iov[3];
+  int handle, byte_cnt;
+
+  memset (rest, 0, sizeof rest);
+  memset (zeros, 0, sizeof zeros);
+  iov[0].iov_base = buf;
+  iov[0].iov_len = 200;
+  iov[1].iov_base = buf + 200;
+  iov[1].iov_len = sizeof buf - 200;
+  iov[2].iov_base = rest;
+  iov[2].iov_len = sizeof rest;
+
+  CHECK ((handle = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  byte_cnt = readv (handle, iov, 3);
+  if (byte_cnt != sizeof sample - 1)
+    fail ("readv() returned %d instead of %zu", byte_cnt, sizeof sample - 1);
+  compare_bytes (buf, sample, sizeof sample - 1, 0, "sample.txt");
+  if (memcmp (rest, zeros, sizeof rest))
+    fail ("readv() wrote to a buffer after a short read");
+}
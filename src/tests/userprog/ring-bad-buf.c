@@ -0,0 +1,19 @@
+/* Queues a read into kernel memory in a ring.
+   The process must be terminated with -1 exit code. */
+
+#include <syscall.h>
+#include "tests/userprog/ring.h"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  int handle;
+
+  CHECK ((handle = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  ring_init (0);
+  ring_submit (RING_READ, handle, (char *) 0xc0100000, 123, 0, 1);
+  ring_enter (1);
+  fail ("should not have survived ring_enter()");
+}
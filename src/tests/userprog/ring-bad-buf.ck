@@ -0,0 +1,17 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF', <<'EOF']);
+(ring-bad-buf) begin
+(ring-bad-buf) open "sample.txt"
+(ring-bad-buf) ring_setup
+(ring-bad-buf) end
+ring-bad-buf: exit(0)
+EOF
+(ring-bad-buf) begin
+(ring-bad-buf) open "sample.txt"
+(ring-bad-buf) ring_setup
+ring-bad-buf: exit(-1)
+EOF
+pass;
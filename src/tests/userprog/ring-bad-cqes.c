@@ -0,0 +1,20 @@
+/* Points a ring's completion queue at kernel memory.
+   The process must be terminated with -1 exit code. */
+
+#include <syscall.h>
+#include "tests/userprog/ring.h"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  int handle;
+
+  CHECK ((handle = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  ring_init (0);
+  ring_submit (RING_SEEK, handle, NULL, 0, 10, 1);
+  ring.cqes = (struct ring_cqe *) 0xc0100000;
+  ring_enter (1);
+  fail ("should not have survived ring_enter()");
+}
@@ -0,0 +1,17 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF', <<'EOF']);
+(ring-bad-cqes) begin
+(ring-bad-cqes) open "sample.txt"
+(ring-bad-cqes) ring_setup
+(ring-bad-cqes) end
+ring-bad-cqes: exit(0)
+EOF
+(ring-bad-cqes) begin
+(ring-bad-cqes) open "sample.txt"
+(ring-bad-cqes) ring_setup
+ring-bad-cqes: exit(-1)
+EOF
+pass;
@@ -0,0 +1,40 @@
+/* Corrupts the indexes of a registered ring.  ring_enter() must
+   then fail without executing anything or touching the ring. */
+
+#include <inttypes.h>
+#include <syscall.h>
+#include "tests/userprog/ring.h"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  int handle;
+
+  CHECK ((handle = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  ring_init (0);
+  ring_submit (RING_SEEK, handle, NULL, 0, 10, 1);
+
+  ring.sq_tail = RING_ENTRIES + 1;
+  CHECK (ring_enter (1) == -1, "ring_enter with corrupt sq_tail (must fail)");
+  ring.sq_tail = 1;
+
+  ring.cq_head = 1;
+  CHECK (ring_enter (1) == -1, "ring_enter with corrupt cq_head (must fail)");
+  ring.cq_head = 0;
+
+  ring.entries = 3;
+  CHECK (ring_enter (1) == -1, "ring_enter with corrupt entries (must fail)");
+  ring.entries = RING_ENTRIES;
+
+  if (ring.sq_head != 0 || ring.cq_tail != 0)
+    fail ("failed ring_enter() moved sq_head to %"PRIu32
+          " and cq_tail to %"PRIu32, ring.sq_head, ring.cq_tail);
+  if (tell (handle) != 0)
+    fail ("failed ring_enter() executed a request");
+
+  CHECK (ring_enter (1) == 1, "ring_enter with the indexes restored");
+  if (ring_complete (1) != 0 || tell (handle) != 10)
+    fail ("queued seek did not run");
+}
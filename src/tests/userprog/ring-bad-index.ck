@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(ring-bad-index) begin
+(ring-bad-index) open "sample.txt"
+(ring-bad-index) ring_setup
+(ring-bad-index) ring_enter with corrupt sq_tail (must fail)
+(ring-bad-index) ring_enter with corrupt cq_head (must fail)
+(ring-bad-index) ring_enter with corrupt entries (must fail)
+(ring-bad-index) ring_enter with the indexes restored
+(ring-bad-index) end
+ring-bad-index: exit(0)
+EOF
+pass;
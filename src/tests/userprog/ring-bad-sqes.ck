@@ -0,0 +1,17 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF', <<'EOF']);
+(ring-bad-sqes) begin
+(ring-bad-sqes) open "sample.txt"
+(ring-bad-sqes) ring_setup
+(ring-bad-sqes) end
+ring-bad-sqes: exit(0)
+EOF
+(ring-bad-sqes) begin
+(ring-bad-sqes) open "sample.txt"
+(ring-bad-sqes) ring_setup
+ring-bad-sqes: exit(-1)
+EOF
+pass;
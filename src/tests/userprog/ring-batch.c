@@ -0,0 +1,45 @@
+/* Opens, seeks, reads and closes a file through the ring, and
+   checks the result and user_data of every completion. */
+
+#include <inttypes.h>
+#include <syscall.h>
+#include "tests/userprog/ring.h"
+#include "tests/userprog/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  char buf[20], buf2[20];
+  int handle;
+
+  ring_init (0);
+  ring_submit (RING_OPEN, 0, (char *) "sample.txt", 0, 0, 1);
+  CHECK (ring_enter (1) == 1, "ring_enter open \"sample.txt\"");
+  CHECK ((handle = ring_complete (1)) > 1, "open \"sample.txt\"");
+
+  ring_submit (RING_SEEK, handle, NULL, 0, 100, 2);
+  ring_submit (RING_READ, handle, buf, sizeof buf, 0, 3);
+  ring_submit (RING_PREAD, handle, buf2, sizeof buf2, 0, 4);
+  ring_submit (RING_CLOSE, handle, NULL, 0, 0, 5);
+  CHECK (ring_enter (3) == 3, "ring_enter 3 of 4 requests");
+  if (ring.sq_head != 4 || ring.cq_tail != 4)
+    fail ("ring_enter() left sq_head at %"PRIu32" and cq_tail at %"PRIu32,
+          ring.sq_head, ring.cq_tail);
+  CHECK (ring_enter (10) == 1, "ring_enter the rest");
+  if (ring.sq_head != 5 || ring.cq_tail != 5)
+    fail ("ring_enter() left sq_head at %"PRIu32" and cq_tail at %"PRIu32,
+          ring.sq_head, ring.cq_tail);
+
+  if (ring_complete (2) != 0)
+    fail ("seek failed");
+  if (ring_complete (3) != sizeof buf)
+    fail ("read did not read %zu bytes", sizeof buf);
+  if (ring_complete (4) != sizeof buf2)
+    fail ("pread did not read %zu bytes", sizeof buf2);
+  if (ring_complete (5) != 0)
+    fail ("close failed");
+  compare_bytes (buf, sample + 100, sizeof buf, 100, "sample.txt");
+  compare_bytes (buf2, sample, sizeof buf2, 0, "sample.txt");
+}
@@ -0,0 +1,15 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(ring-batch) begin
+(ring-batch) ring_setup
+(ring-batch) ring_enter open "sample.txt"
+(ring-batch) open "sample.txt"
+(ring-batch) ring_enter 3 of 4 requests
+(ring-batch) ring_enter the rest
+(ring-batch) end
+ring-batch: exit(0)
+EOF
+pass;
@@ -0,0 +1,44 @@
+/* Fills the completion queue and checks that ring_enter()
+   executes only as many requests as there are free completion
+   slots. */
+
+#include <inttypes.h>
+#include <syscall.h>
+#include "tests/userprog/ring.h"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  int handle, i;
+
+  CHECK ((handle = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  ring_init (0);
+
+  for (i = 0; i < RING_ENTRIES; i++)
+    ring_submit (RING_SEEK, handle, NULL, 0, i, i);
+  CHECK (ring_enter (RING_ENTRIES) == RING_ENTRIES,
+         "ring_enter to fill the completion queue");
+  if (ring.sq_head != RING_ENTRIES || ring.cq_tail != RING_ENTRIES)
+    fail ("ring_enter() left sq_head at %"PRIu32" and cq_tail at %"PRIu32,
+          ring.sq_head, ring.cq_tail);
+
+  ring_submit (RING_SEEK, handle, NULL, 0, 100, 100);
+  ring_submit (RING_SEEK, handle, NULL, 0, 101, 101);
+  CHECK (ring_enter (2) == 0, "ring_enter with a full completion queue");
+  if (ring.sq_head != RING_ENTRIES || tell (handle) != RING_ENTRIES - 1)
+    fail ("ring_enter() executed a request with no free completion slot");
+
+  ring_complete (0);
+  CHECK (ring_enter (2) == 1, "ring_enter with one free completion slot");
+  if (ring.sq_head != RING_ENTRIES + 1 || tell (handle) != 100)
+    fail ("ring_enter() did not execute exactly one request");
+
+  for (i = 1; i < RING_ENTRIES; i++)
+    ring_complete (i);
+  ring_complete (100);
+  CHECK (ring_enter (2) == 1, "ring_enter for the last request");
+  if (ring_complete (101) != 0 || tell (handle) != 101)
+    fail ("last request did not run");
+}
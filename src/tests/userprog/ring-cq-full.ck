@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(ring-cq-full) begin
+(ring-cq-full) open "sample.txt"
+(ring-cq-full) ring_setup
+(ring-cq-full) ring_enter to fill the completion queue
+(ring-cq-full) ring_enter with a full completion queue
+(ring-cq-full) ring_enter with one free completion slot
+(ring-cq-full) ring_enter for the last request
+(ring-cq-full) end
+ring-cq-full: exit(0)
+EOF
+pass;
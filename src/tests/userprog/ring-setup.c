@@ -0,0 +1,30 @@
+/* Checks that ring_setup() accepts only a power of two entries
+   up to RING_MAX_ENTRIES, and that ring_enter() fails when no
+   ring is registered. */
+
+#include <syscall.h>
+#include "tests/userprog/ring.h"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  CHECK (ring_enter (1) == -1, "ring_enter without a ring (must fail)");
+
+  ring.entries = 0;
+  CHECK (!ring_setup (&ring), "ring_setup with 0 entries (must fail)");
+  ring.entries = 3;
+  CHECK (!ring_setup (&ring), "ring_setup with 3 entries (must fail)");
+  ring.entries = RING_MAX_ENTRIES * 2;
+  CHECK (!ring_setup (&ring), "ring_setup with %d entries (must fail)",
+         RING_MAX_ENTRIES * 2);
+  CHECK (ring_enter (1) == -1, "ring_enter after failed ring_setup (must fail)");
+
+  ring_init (0);
+  CHECK (ring_enter (1) == 0, "ring_enter with nothing queued");
+
+  CHECK (ring_setup (NULL), "ring_setup (NULL)");
+  CHECK (ring_enter (1) == -1,
+         "ring_enter after ring_setup (NULL) (must fail)");
+}
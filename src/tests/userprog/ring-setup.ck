@@ -0,0 +1,19 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(ring-setup) begin
+(ring-setup) ring_enter without a ring (must fail)
+(ring-setup) ring_setup with 0 entries (must fail)
+(ring-setup) ring_setup with 3 entries (must fail)
+(ring-setup) ring_setup with 8192 entries (must fail)
+(ring-setup) ring_enter after failed ring_setup (must fail)
+(ring-setup) ring_setup
+(ring-setup) ring_enter with nothing queued
+(ring-setup) ring_setup (NULL)
+(ring-setup) ring_enter after ring_setup (NULL) (must fail)
+(ring-setup) end
+ring-setup: exit(0)
+EOF
+pass;
@@ -0,0 +1,32 @@
+/* Starts a ring's indexes just below UINT32_MAX, so that they
+   wrap around to 0 in the middle of a batch. */
+
+#include <inttypes.h>
+#include <stdint.h>
+#include <syscall.h>
+#include "tests/userprog/ring.h"
+#include "tests/userprog/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  char buf[RING_ENTRIES * 10];
+  int handle, i;
+
+  CHECK ((handle = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  ring_init (UINT32_MAX - 1);
+  for (i = 0; i < RING_ENTRIES; i++)
+    ring_submit (RING_PREAD, handle, buf + i * 10, 10, i * 10, 100 + i);
+
+  CHECK (ring_enter (RING_ENTRIES) == RING_ENTRIES,
+         "ring_enter across index wraparound");
+  if (ring.sq_head != RING_ENTRIES - 2 || ring.cq_tail != RING_ENTRIES - 2)
+    fail ("ring_enter() left sq_head at %"PRIu32" and cq_tail at %"PRIu32,
+          ring.sq_head, ring.cq_tail);
+  for (i = 0; i < RING_ENTRIES; i++)
+    if (ring_complete (100 + i) != 10)
+      fail ("pread %d did not read 10 bytes", i);
+  compare_bytes (buf, sample, sizeof buf, 0, "sample.txt");
+}
@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(ring-wrap) begin
+(ring-wrap) open "sample.txt"
+(ring-wrap) ring_setup
+(ring-wrap) ring_enter across index wraparound
+(ring-wrap) end
+ring-wrap: exit(0)
+EOF
+pass;
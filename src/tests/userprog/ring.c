@@ -0,0 +1,61 @@
+/* Utility functions for tests of the batched system call
+   ring. */
+
+#include <inttypes.h>
+#include "tests/userprog/ring.h"
+#include "tests/lib.h"
+
+static struct ring_sqe sqes[RING_ENTRIES];
+static struct ring_cqe cqes[RING_ENTRIES];
+
+/* The test ring. */
+struct syscall_ring ring;
+
+/* Empties the test ring, starting all four of its indexes at
+   START, and registers it with the kernel. */
+void
+ring_init (uint32_t start) 
+{
+  ring.sq_head = ring.sq_tail = start;
+  ring.cq_head = ring.cq_tail = start;
+  ring.entries = RING_ENTRIES;
+  ring.sqes = sqes;
+  ring.cqes = cqes;
+  CHECK (ring_setup (&ring), "ring_setup");
+}
+
+/* Queues a request in the test ring's submission queue. */
+void
+ring_submit (enum ring_op op, int fd, void *buf, uint32_t len,
+             uint32_t offset, uint32_t user_data) 
+{
+  struct ring_sqe *sqe;
+
+  if (ring.sq_tail - ring.sq_head >= RING_ENTRIES)
+    fail ("submission queue full");
+  sqe = &ring.sqes[ring.sq_tail % RING_ENTRIES];
+  sqe->op = op;
+  sqe->fd = fd;
+  sqe->buf = buf;
+  sqe->len = len;
+  sqe->offset = offset;
+  sqe->user_data = user_data;
+  ring.sq_tail++;
+}
+
+/* Consumes the oldest completion in the test ring, which must
+   carry USER_DATA, and returns its result. */
+int
+ring_complete (uint32_t user_data) 
+{
+  struct ring_cqe *cqe;
+
+  if (ring.cq_head == ring.cq_tail)
+    fail ("completion queue empty");
+  cqe = &ring.cqes[ring.cq_head % RING_ENTRIES];
+  if (cqe->user_data != user_data)
+    fail ("completion has user_data %"PRIu32" instead of %"PRIu32,
+          cqe->user_data, user_data);
+  ring.cq_head++;
+  return cqe->result;
+}
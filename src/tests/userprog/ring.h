@@ -0,0 +1,17 @@
+#ifndef TESTS_USERPROG_RING_H
+#define TESTS_USERPROG_RING_H
+
+#include <stdint.h>
+#include <syscall.h>
+
+/* Number of slots in each queue of the test ring. */
+#define RING_ENTRIES 4
+
+extern struct syscall_ring ring;
+
+void ring_init (uint32_t start);
+void ring_submit (enum ring_op, int fd, void *buf, uint32_t len,
+                  uint32_t offset, uint32_t user_data);
+int ring_complete (uint32_t user_data);
+
+#endif /* tests/userprog/ring.h */
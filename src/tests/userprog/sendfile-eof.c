@@ -0,0 +1,28 @@
+/* Asks sendfile() for more bytes than remain in the input file.
+   It must copy what there is and return a short count. */
+
+#include <syscall.h>
+#include "tests/userprog/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  int in_fd, out_fd, byte_cnt;
+
+  CHECK ((in_fd = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  CHECK (create ("test.txt", sizeof sample - 1 - 200), "create \"test.txt\"");
+  CHECK ((out_fd = open ("test.txt")) > 1, "open \"test.txt\"");
+
+  byte_cnt = sendfile (out_fd, in_fd, 200, 1000);
+  if (byte_cnt != sizeof sample - 1 - 200)
+    fail ("sendfile() returned %d instead of %zu",
+          byte_cnt, sizeof sample - 1 - 200);
+  CHECK (sendfile (out_fd, in_fd, sizeof sample - 1, 10) == 0,
+         "sendfile at end of file");
+  msg ("close \"test.txt\"");
+  close (out_fd);
+
+  check_file ("test.txt", sample + 200, sizeof sample - 1 - 200);
+}
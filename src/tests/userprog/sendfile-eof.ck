@@ -0,0 +1,18 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(sendfile-eof) begin
+(sendfile-eof) open "sample.txt"
+(sendfile-eof) create "test.txt"
+(sendfile-eof) open "test.txt"
+(sendfile-eof) sendfile at end of file
+(sendfile-eof) close "test.txt"
+(sendfile-eof) open "test.txt" for verification
+(sendfile-eof) verified contents of "test.txt"
+(sendfile-eof) close "test.txt"
+(sendfile-eof) end
+sendfile-eof: exit(0)
+EOF
+pass;
@@ -0,0 +1,35 @@
+/* Passes sendfile() a directory, a negative offset, and the
+   console's input as its output.  Each call must return -1. */
+
+#include <limits.h>
+#include <stdio.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  int in_fd, out_fd, dir_fd;
+
+  CHECK ((in_fd = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  CHECK (create ("test.txt", 0), "create \"test.txt\"");
+  CHECK ((out_fd = open ("test.txt")) > 1, "open \"test.txt\"");
+  CHECK (mkdir ("a"), "mkdir \"a\"");
+  CHECK ((dir_fd = open ("a")) > 1, "open \"a\"");
+
+  CHECK (sendfile (out_fd, dir_fd, 0, 10) == -1,
+         "sendfile from a directory (must fail)");
+  CHECK (sendfile (dir_fd, in_fd, 0, 10) == -1,
+         "sendfile to a directory (must fail)");
+  CHECK (sendfile (out_fd, in_fd, -1, 10) == -1,
+         "sendfile at offset -1 (must fail)");
+  CHECK (sendfile (out_fd, in_fd, INT_MIN, 10) == -1,
+         "sendfile at offset INT_MIN (must fail)");
+  CHECK (sendfile (STDIN_FILENO, in_fd, 0, 10) == -1,
+         "sendfile to STDIN (must fail)");
+
+  if (filesize (out_fd) != 0)
+    fail ("failed sendfile() changed size of \"test.txt\" to %d",
+          filesize (out_fd));
+}
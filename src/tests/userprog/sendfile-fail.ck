@@ -0,0 +1,20 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(sendfile-fail) begin
+(sendfile-fail) open "sample.txt"
+(sendfile-fail) create "test.txt"
+(sendfile-fail) open "test.txt"
+(sendfile-fail) mkdir "a"
+(sendfile-fail) open "a"
+(sendfile-fail) sendfile from a directory (must fail)
+(sendfile-fail) sendfile to a directory (must fail)
+(sendfile-fail) sendfile at offset -1 (must fail)
+(sendfile-fail) sendfile at offset INT_MIN (must fail)
+(sendfile-fail) sendfile to STDIN (must fail)
+(sendfile-fail) end
+sendfile-fail: exit(0)
+EOF
+pass;
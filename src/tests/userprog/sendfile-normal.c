@@ -0,0 +1,29 @@
+/* Copies a whole file to another with sendfile() and checks
+   the copy. */
+
+#include <syscall.h>
+#include "tests/userprog/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  int in_fd, out_fd, byte_cnt;
+
+  CHECK ((in_fd = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  CHECK (create ("test.txt", sizeof sample - 1), "create \"test.txt\"");
+  CHECK ((out_fd = open ("test.txt")) > 1, "open \"test.txt\"");
+
+  byte_cnt = sendfile (out_fd, in_fd, 0, sizeof sample - 1);
+  if (byte_cnt != sizeof sample - 1)
+    fail ("sendfile() returned %d instead of %zu",
+          byte_cnt, sizeof sample - 1);
+  if (tell (out_fd) != sizeof sample - 1)
+    fail ("file position of \"test.txt\" is %u instead of %zu",
+          tell (out_fd), sizeof sample - 1);
+  msg ("close \"test.txt\"");
+  close (out_fd);
+
+  check_file ("test.txt", sample, sizeof sample - 1);
+}
@@ -0,0 +1,29 @@
+/* Copies part of a file from an offset with sendfile(), which
+   must not move the input file's position. */
+
+#include <syscall.h>
+#include "tests/userprog/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  int in_fd, out_fd, byte_cnt;
+
+  CHECK ((in_fd = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  CHECK (create ("test.txt", 50), "create \"test.txt\"");
+  CHECK ((out_fd = open ("test.txt")) > 1, "open \"test.txt\"");
+  seek (in_fd, 7);
+
+  byte_cnt = sendfile (out_fd, in_fd, 100, 50);
+  if (byte_cnt != 50)
+    fail ("sendfile() returned %d instead of 50", byte_cnt);
+  if (tell (in_fd) != 7)
+    fail ("sendfile() moved position of \"sample.txt\" from 7 to %u",
+          tell (in_fd));
+  msg ("close \"test.txt\"");
+  close (out_fd);
+
+  check_file ("test.txt", sample + 100, 50);
+}
@@ -0,0 +1,17 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(sendfile-offset) begin
+(sendfile-offset) open "sample.txt"
+(sendfile-offset) create "test.txt"
+(sendfile-offset) open "test.txt"
+(sendfile-offset) close "test.txt"
+(sendfile-offset) open "test.txt" for verification
+(sendfile-offset) verified contents of "test.txt"
+(sendfile-offset) close "test.txt"
+(sendfile-offset) end
+sendfile-offset: exit(0)
+EOF
+pass;
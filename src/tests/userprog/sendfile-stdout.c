@@ -0,0 +1,19 @@
+/* Copies a file to the console with sendfile(). */
+
+#include <stdio.h>
+#include <syscall.h>
+#include "tests/userprog/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  int in_fd, byte_cnt;
+
+  CHECK ((in_fd = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  byte_cnt = sendfile (STDOUT_FILENO, in_fd, 0, sizeof sample - 1);
+  if (byte_cnt != sizeof sample - 1)
+    fail ("sendfile() returned %d instead of %zu",
+          byte_cnt, sizeof sample - 1);
+}
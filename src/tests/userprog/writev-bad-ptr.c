@@ -0,0 +1,27 @@
+/* Passes writev() an invalid pointer in the middle of its
+   buffer array.
+   The process must be terminated with -1 exit code. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  char buf[2][16];
+  struct iovec iov[3];
+  int handle;
+
+  iov[0].iov_base = buf[0];
+  iov[0].iov_len = sizeof buf[0];
+  iov[1].iov_base = (char *) 0xc0100000;
+  iov[1].iov_len = 123;
+  iov[2].iov_base = buf[1];
+  iov[2].iov_len = sizeof buf[1];
+
+  CHECK (create ("test.txt", 0), "create \"test.txt\"");
+  CHECK ((handle = open ("test.txt")) > 1, "open \"test.txt\"");
+  writev (handle, iov, 3);
+  fail ("should not have survived writev()");
+}
@@ -0,0 +1,17 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF', <<'EOF']);
+(writev-bad-ptr) begin
+(writev-bad-ptr) create "test.txt"
+(writev-bad-ptr) open "test.txt"
+(writev-bad-ptr) end
+writev-bad-ptr: exit(0)
+EOF
+(writev-bad-ptr) begin
+(writev-bad-ptr) create "test.txt"
+(writev-bad-ptr) open "test.txt"
+writev-bad-ptr: exit(-1)
+EOF
+pass;
@@ -0,0 +1,34 @@
+/* Writes a file from three buffers with one writev() and
+   checks the file's contents. */
+
+#include <syscall.h>
+#include "tests/userprog/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  struct iovec iov[3];
+  int handle, byte_cnt;
+
+  iov[0].iov_base = sample;
+  iov[0].iov_len = 100;
+  iov[1].iov_base = sample + 100;
+  iov[1].iov_len = 1;
+  iov[2].iov_base = sample + 101;
+  iov[2].iov_len = sizeof sample - 1 - 101;
+
+  CHECK (create ("test.txt", sizeof sample - 1), "create \"test.txt\"");
+  CHECK ((handle = open ("test.txt")) > 1, "open \"test.txt\"");
+  byte_cnt = writev (handle, iov, 3);
+  if (byte_cnt != sizeof sample - 1)
+    fail ("writev() returned %d instead of %zu", byte_cnt, sizeof sample - 1);
+  if (tell (handle) != sizeof sample - 1)
+    fail ("file position is %u after writev() instead of %zu",
+          tell (handle), sizeof sample - 1);
+  msg ("close \"test.txt\"");
+  close (handle);
+
+  check_file ("test.txt", sample, sizeof sample - 1);
+}
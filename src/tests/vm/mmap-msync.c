@@ -0,0 +1,49 @@
+/* Modifies a mapped file through its mapping and calls msync,
+   then reads the file back with the read system call, before
+   unmapping it, to verify that the data was written back and
+   that the bytes past the end of the file in its partial last
+   page were not.  Also checks that msync rejects a bad mapping
+   id. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define ACTUAL ((void *) 0x10000000)
+
+/* One full page and a partial one. */
+#define FILE_SIZE (4096 + 100)
+
+static char buf[FILE_SIZE];
+
+void
+test_main (void)
+{
+  char *actual = ACTUAL;
+  int handle;
+  mapid_t map;
+  size_t i;
+
+  CHECK (create ("data", FILE_SIZE), "create \"data\"");
+  CHECK ((handle = open ("data")) > 1, "open \"data\"");
+  CHECK ((map = mmap (handle, actual)) != MAP_FAILED, "mmap \"data\"");
+
+  /* Fill the mapping, including the tail of the last page that
+     lies past the end of the file. */
+  for (i = 0; i < FILE_SIZE; i++)
+    actual[i] = i % 251;
+  memset (actual + FILE_SIZE, 'x', 2 * 4096 - FILE_SIZE);
+
+  CHECK (msync (map) == 0, "msync \"data\"");
+  CHECK (filesize (handle) == FILE_SIZE, "filesize \"data\" unchanged");
+  CHECK (read (handle, buf, sizeof buf) == FILE_SIZE, "read \"data\"");
+  compare_bytes (buf, actual, FILE_SIZE, 0, "data");
+  msg ("compare read data against mapped data");
+
+  CHECK (msync (map + 1) == -1, "msync bad mapping id");
+
+  msg ("munmap \"data\"");
+  munmap (map);
+  close (handle);
+}
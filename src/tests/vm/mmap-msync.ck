@@ -0,0 +1,18 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(mmap-msync) begin
+(mmap-msync) create "data"
+(mmap-msync) open "data"
+(mmap-msync) mmap "data"
+(mmap-msync) msync "data"
+(mmap-msync) filesize "data" unchanged
+(mmap-msync) read "data"
+(mmap-msync) compare read data against mapped data
+(mmap-msync) msync bad mapping id
+(mmap-msync) munmap "data"
+(mmap-msync) end
+EOF
+pass;
@@ -134,6 +134,8 @@ main (void)
 #endif
   frame_init ();
   swap_init ();
+  page_init ();
+  pageout_init ();
   printf ("Boot complete.\n");
   
   /* Run actions specified on kernel command line. */
@@ -4,6 +4,7 @@
 #include <random.h>
 #include <stdio.h>
 #include <string.h>
+#include "devices/timer.h"
 #include "threads/flags.h"
 #include "threads/interrupt.h"
 #include "threads/intr-stubs.h"
@@ -20,9 +21,14 @@
    of thread.h for details. */
 #define THREAD_MAGIC 0xcd6abf4b
 
-/* List of processes in THREAD_READY state, that is, processes
-   that are ready to run but not actually running. */
-static struct list ready_list;
+/* Processes in THREAD_READY state, that is, processes that are
+   ready to run but not actually running, with one first come
+   first served queue per priority.  Bit P of ready_mask is set
+   if and only if ready_queues[P] is not empty, so that the
+   highest nonempty queue can be found without a search. */
+static struct list ready_queues[PRI_MAX + 1];
+static uint64_t ready_mask;
+static int ready_cnt;           /* Number of threads in ready_queues. */
 
 /* List of all processes.  Processes are added to this list
    when they are first scheduled and removed when they exit. */
@@ -52,6 +58,16 @@ static long long user_ticks;    /* # of timer ticks in user programs. */
 
 /* Scheduling. */
 #define TIME_SLICE 4            /* # of timer ticks to give each thread. */
+#define DONATION_DEPTH 8        /* Max. length of a donation chain. */
+#define PRIORITY_INTERVAL 4     /* # of ticks between MLFQS priority updates. */
+
+/* MLFQS scheduler state. */
+static fixed_point load_avg;    /* Estimated # of threads ready to run. */
+
+/* Threads whose recent_cpu grew since the last priority update.
+   Between the once-per-second updates of every thread, these are
+   the only threads whose MLFQS priority can have changed. */
+static struct list charged_list;
 static unsigned thread_ticks;   /* # of timer ticks since last yield. */
 
 /* If false (default), use round-robin scheduler.
@@ -66,6 +82,13 @@ static struct thread *running_thread (void);
 static struct thread *next_thread_to_run (void);
 static void init_thread (struct thread *, const char *name, int priority);
 static bool is_thread (struct thread *) UNUSED;
+static void ready_list_insert (struct thread *);
+static void ready_list_remove (struct thread *);
+static int ready_list_max_priority (void);
+static void mlfqs_tick (struct thread *);
+static int mlfqs_priority (const struct thread *);
+static void mlfqs_update_priority (struct thread *, void *aux);
+static void mlfqs_update_recent_cpu (struct thread *, void *aux);
 static void *alloc_frame (struct thread *, size_t size);
 static void schedule (void);
 void thread_schedule_tail (struct thread *prev);
@@ -87,10 +110,17 @@ static tid_t allocate_tid (void);
 void
 thread_init (void) 
 {
+  int i;
+
   ASSERT (intr_get_level () == INTR_OFF);
 
   lock_init (&tid_lock);
-  list_init (&ready_list);
+  for (i = 0; i <= PRI_MAX; i++)
+    list_init (&ready_queues[i]);
+  ready_mask = 0;
+  ready_cnt = 0;
+  list_init (&charged_list);
+  load_avg = 0;
   list_init (&all_list);
 
   /* Set up a thread structure for the running thread. */
@@ -134,6 +164,9 @@ thread_tick (void)
   else
     kernel_ticks++;
 
+  if (thread_mlfqs)
+    mlfqs_tick (t);
+
   /* Enforce preemption. */
   if (++thread_ticks >= TIME_SLICE)
     intr_yield_on_return ();
@@ -159,9 +192,8 @@ thread_print_stats (void)
    scheduled.  Use a semaphore or some other form of
    synchronization if you need to ensure ordering.
 
-   The code provided sets the new thread's `priority' member to
-   PRIORITY, but no actual priority scheduling is implemented.
-   Priority scheduling is the goal of Problem 1-3. */
+   If the new thread has higher priority than the running thread,
+   it runs before thread_create() returns. */
 tid_t
 thread_create (const char *name, int priority,
                thread_func *function, void *aux) 
@@ -200,8 +232,10 @@ thread_create (const char *name, int priority,
   sf->eip = switch_entry;
   sf->ebp = 0;
 
-  /* Add to run queue. */
+  /* Add to run queue, and run it right away if it outranks
+     us. */
   thread_unblock (t);
+  thread_preempt ();
 
   return tid;
 }
@@ -226,10 +260,11 @@ thread_block (void)
    This is an error if T is not blocked.  (Use thread_yield() to
    make the running thread ready.)
 
-   This function does not preempt the running thread.  This can
-   be important: if the caller had disabled interrupts itself,
-   it may expect that it can atomically unblock a thread and
-   update other data. */
+   This function does not preempt the running thread, even if T
+   has higher priority.  This can be important: if the caller had
+   disabled interrupts itself, it may expect that it can
+   atomically unblock a thread and update other data.  Call
+   thread_preempt() afterward to yield to T if appropriate. */
 void
 thread_unblock (struct thread *t) 
 {
@@ -239,7 +274,7 @@ thread_unblock (struct thread *t)
 
   old_level = intr_disable ();
   ASSERT (t->status == THREAD_BLOCKED);
-  list_push_back (&ready_list, &t->elem);
+  ready_list_insert (t);
   t->status = THREAD_READY;
   intr_set_level (old_level);
 }
@@ -293,6 +328,8 @@ thread_exit (void)
      when it calls thread_schedule_tail(). */
   intr_disable ();
   list_remove (&thread_current()->allelem);
+  if (thread_current ()->charged)
+    list_remove (&thread_current ()->charged_elem);
   thread_current ()->status = THREAD_DYING;
   schedule ();
   NOT_REACHED ();
@@ -310,7 +347,7 @@ thread_yield (void)
 
   old_level = intr_disable ();
   if (cur != idle_thread) 
-    list_push_back (&ready_list, &cur->elem);
+    ready_list_insert (cur);
   cur->status = THREAD_READY;
   schedule ();
   intr_set_level (old_level);
@@ -333,49 +370,311 @@ thread_foreach (thread_action_func *func, void *aux)
     }
 }
 
-/* Sets the current thread's priority to NEW_PRIORITY. */
+/* Sets the current thread's priority to NEW_PRIORITY.  Donated
+   priority still applies on top of it.  Yields if the current
+   thread no longer has the highest priority.  Does nothing under
+   the MLFQS scheduler, which sets priorities itself. */
 void
 thread_set_priority (int new_priority) 
 {
-  thread_current ()->priority = new_priority;
+  struct thread *cur = thread_current ();
+  enum intr_level old_level;
+
+  if (thread_mlfqs)
+    return;
+
+  old_level = intr_disable ();
+  cur->base_priority = new_priority;
+  thread_update_priority (cur);
+  thread_preempt ();
+  intr_set_level (old_level);
 }
 
-/* Returns the current thread's priority. */
+/* Returns the current thread's priority, including any
+   donations. */
 int
 thread_get_priority (void) 
 {
   return thread_current ()->priority;
 }
 
-/* Sets the current thread's nice value to NICE. */
+/* Returns true if the thread with list element A (its `elem')
+   has lower priority than the one with list element B. */
+bool
+thread_priority_less (const struct list_elem *a_,
+                      const struct list_elem *b_, void *aux UNUSED)
+{
+  const struct thread *a = list_entry (a_, struct thread, elem);
+  const struct thread *b = list_entry (b_, struct thread, elem);
+
+  return a->priority < b->priority;
+}
+
+/* Adds T to the back of the ready queue for its priority.
+   Interrupts must be off. */
+static void
+ready_list_insert (struct thread *t)
+{
+  list_push_back (&ready_queues[t->priority], &t->elem);
+  ready_mask |= (uint64_t) 1 << t->priority;
+  ready_cnt++;
+}
+
+/* Removes T, which must be ready, from its ready queue.  Must be
+   called before T's priority changes.  Interrupts must be off. */
+static void
+ready_list_remove (struct thread *t)
+{
+  list_remove (&t->elem);
+  if (list_empty (&ready_queues[t->priority]))
+    ready_mask &= ~((uint64_t) 1 << t->priority);
+  ready_cnt--;
+}
+
+/* Returns the priority of the highest-priority ready thread, or
+   -1 if no thread is ready.  Interrupts must be off. */
+static int
+ready_list_max_priority (void)
+{
+  uint32_t high = ready_mask >> 32;
+  uint32_t low = ready_mask;
+
+  if (high != 0)
+    return 63 - __builtin_clz (high);
+  else if (low != 0)
+    return 31 - __builtin_clz (low);
+  else
+    return -1;
+}
+
+/* Yields the CPU if a ready thread has higher priority than the
+   running thread.  In an interrupt handler, yields on return
+   from the interrupt instead. */
 void
-thread_set_nice (int nice UNUSED) 
+thread_preempt (void)
 {
-  /* Not yet implemented. */
+  enum intr_level old_level = intr_disable ();
+
+  if (thread_current () != idle_thread
+      && ready_list_max_priority () > thread_current ()->priority)
+    {
+      if (intr_context ())
+        intr_yield_on_return ();
+      else
+        thread_yield ();
+    }
+  intr_set_level (old_level);
+}
+
+/* Passes T's priority on to the holder of the lock T waits for,
+   then on to the holder of the lock that thread waits for, and
+   so on, for up to DONATION_DEPTH links.  Interrupts must be
+   off. */
+void
+thread_donate_priority (struct thread *t)
+{
+  int depth;
+
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  for (depth = 0; depth < DONATION_DEPTH && t->wait_lock != NULL; depth++)
+    {
+      struct thread *holder = t->wait_lock->holder;
+
+      if (holder == NULL || holder->priority >= t->priority)
+        break;
+      if (holder->status == THREAD_READY)
+        {
+          ready_list_remove (holder);
+          holder->priority = t->priority;
+          ready_list_insert (holder);
+        }
+      else
+        holder->priority = t->priority;
+      t = holder;
+    }
+}
+
+/* Recomputes T's priority as the greater of its base priority
+   and the priorities of the threads waiting for locks it holds.
+   T must not be on the ready list.  Interrupts must be off. */
+void
+thread_update_priority (struct thread *t)
+{
+  struct list_elem *l, *w;
+
+  ASSERT (intr_get_level () == INTR_OFF);
+  ASSERT (t->status != THREAD_READY);
+
+  t->priority = t->base_priority;
+  for (l = list_begin (&t->locks); l != list_end (&t->locks);
+       l = list_next (l))
+    {
+      struct list *waiters
+        = &list_entry (l, struct lock, elem)->semaphore.waiters;
+
+      for (w = list_begin (waiters); w != list_end (waiters);
+           w = list_next (w))
+        {
+          struct thread *waiter = list_entry (w, struct thread, elem);
+          if (waiter->priority > t->priority)
+            t->priority = waiter->priority;
+        }
+    }
+}
+
+/* Sets the current thread's nice value to NICE and recomputes
+   its priority, yielding if it no longer has the highest
+   priority. */
+void
+thread_set_nice (int nice) 
+{
+  struct thread *cur = thread_current ();
+  enum intr_level old_level;
+
+  ASSERT (nice >= NICE_MIN && nice <= NICE_MAX);
+
+  old_level = intr_disable ();
+  cur->nice = nice;
+  if (thread_mlfqs)
+    {
+      mlfqs_update_priority (cur, NULL);
+      thread_preempt ();
+    }
+  intr_set_level (old_level);
 }
 
 /* Returns the current thread's nice value. */
 int
 thread_get_nice (void) 
 {
-  /* Not yet implemented. */
-  return 0;
+  return thread_current ()->nice;
 }
 
 /* Returns 100 times the system load average. */
 int
 thread_get_load_avg (void) 
 {
-  /* Not yet implemented. */
-  return 0;
+  enum intr_level old_level = intr_disable ();
+  int load_avg_100 = fp_round (fp_mul_int (load_avg, 100));
+  intr_set_level (old_level);
+  return load_avg_100;
 }
 
 /* Returns 100 times the current thread's recent_cpu value. */
 int
 thread_get_recent_cpu (void) 
 {
-  /* Not yet implemented. */
-  return 0;
+  enum intr_level old_level = intr_disable ();
+  int recent_cpu_100
+    = fp_round (fp_mul_int (thread_current ()->recent_cpu, 100));
+  intr_set_level (old_level);
+  return recent_cpu_100;
+}
+
+/* Does the MLFQS scheduler's accounting for a timer tick, during
+   which CUR was running.  Runs in the timer interrupt. */
+static void
+mlfqs_tick (struct thread *cur)
+{
+  int64_t now = timer_ticks ();
+
+  if (cur != idle_thread)
+    {
+      cur->recent_cpu = fp_add_int (cur->recent_cpu, 1);
+      if (!cur->charged)
+        {
+          cur->charged = true;
+          list_push_back (&charged_list, &cur->charged_elem);
+        }
+    }
+
+  if (now % TIMER_FREQ == 0)
+    {
+      /* Once a second, every thread's recent_cpu decays, so every
+         thread's priority needs recomputing. */
+      int ready_threads = ready_cnt + (cur != idle_thread ? 1 : 0);
+
+      load_avg = fp_add (fp_div_int (fp_mul_int (load_avg, 59), 60),
+                         fp_div_int (fp_from_int (ready_threads), 60));
+      thread_foreach (mlfqs_update_recent_cpu, NULL);
+      thread_foreach (mlfqs_update_priority, NULL);
+      while (!list_empty (&charged_list))
+        list_entry (list_pop_front (&charged_list),
+                    struct thread, charged_elem)->charged = false;
+    }
+  else if (now % PRIORITY_INTERVAL == 0)
+    {
+      /* Otherwise only the threads that ran since the last update
+         can have a new priority. */
+      while (!list_empty (&charged_list))
+        {
+          struct thread *t = list_entry (list_pop_front (&charged_list),
+                                         struct thread, charged_elem);
+          t->charged = false;
+          mlfqs_update_priority (t, NULL);
+        }
+    }
+  else
+    return;
+
+  thread_preempt ();
+}
+
+/* Returns T's MLFQS priority, computed from its recent_cpu and
+   nice values. */
+static int
+mlfqs_priority (const struct thread *t)
+{
+  int priority = (PRI_MAX - fp_trunc (fp_div_int (t->recent_cpu, 4))
+                  - t->nice * 2);
+
+  if (priority < PRI_MIN)
+    return PRI_MIN;
+  else if (priority > PRI_MAX)
+    return PRI_MAX;
+  else
+    return priority;
+}
+
+/* Recomputes T's MLFQS priority, moving it to the right ready
+   queue if it is ready.  Interrupts must be off.  Can be passed
+   to thread_foreach(). */
+static void
+mlfqs_update_priority (struct thread *t, void *aux UNUSED)
+{
+  int priority;
+
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  if (t == idle_thread)
+    return;
+
+  priority = mlfqs_priority (t);
+
+  if (priority != t->priority && t->status == THREAD_READY)
+    {
+      ready_list_remove (t);
+      t->priority = t->base_priority = priority;
+      ready_list_insert (t);
+    }
+  else
+    t->priority = t->base_priority = priority;
+}
+
+/* Decays T's recent_cpu, as done once a second.  Interrupts must
+   be off.  Can be passed to thread_foreach(). */
+static void
+mlfqs_update_recent_cpu (struct thread *t, void *aux UNUSED)
+{
+  fixed_point twice_load = fp_mul_int (load_avg, 2);
+
+  if (t == idle_thread)
+    return;
+  t->recent_cpu = fp_add_int (fp_mul (fp_div (twice_load,
+                                              fp_add_int (twice_load, 1)),
+                                      t->recent_cpu),
+                              t->nice);
 }
 
 /* Idle thread.  Executes when no other thread is ready to run.
@@ -463,10 +762,22 @@ init_thread (struct thread *t, const char *name, int priority)
   t->status = THREAD_BLOCKED;
   strlcpy (t->name, name, sizeof t->name);
   t->stack = (uint8_t *) t + PGSIZE;
-  t->priority = priority;
+  t->priority = t->base_priority = priority;
+  list_init (&t->locks);
+  t->wait_lock = NULL;
+
+  /* Inherit the MLFQS inputs of the creating thread.  The initial
+     thread, which creates itself, starts from zero. */
+  t->nice = running_thread ()->nice;
+  t->recent_cpu = running_thread ()->recent_cpu;
+  t->charged = false;
+  if (thread_mlfqs)
+    t->priority = t->base_priority = mlfqs_priority (t);
   t->magic = THREAD_MAGIC;
 
   t->pages=NULL;
+  t->fault_last=NULL;
+  t->fault_run=0;
 
   list_init (&t->alive_children_list);
   list_init (&t->dead_children_list);
@@ -475,13 +786,14 @@ init_thread (struct thread *t, const char *name, int priority)
   sema_init(&t->waiting_sema,0);
   t->exit_status=0;
 
-  list_init (&t->file_list);
+  t->files.slots=NULL;
+  t->files.used=NULL;
+  t->mappings.slots=NULL;
+  t->mappings.used=NULL;
   list_init (&t->mapping_list);
-  t->file_open=0;
-  t->max_fd=2;
-  t->map_cnt=0;
-  t->max_mapid=0;
   t->executable_file=NULL;
+  t->ring=NULL;
+  t->cwd=NULL;
 
   sema_init(&t->child_load,0);
   t->is_loaded=false;
@@ -512,10 +824,14 @@ alloc_frame (struct thread *t, size_t size)
 static struct thread *
 next_thread_to_run (void) 
 {
-  if (list_empty (&ready_list))
+  int priority = ready_list_max_priority ();
+  struct thread *t;
+
+  if (priority < 0)
     return idle_thread;
-  else
-    return list_entry (list_pop_front (&ready_list), struct thread, elem);
+  t = list_entry (list_front (&ready_queues[priority]), struct thread, elem);
+  ready_list_remove (t);
+  return t;
 }
 
 /* Completes a thread switch by activating the new thread's page
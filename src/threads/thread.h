@@ -5,6 +5,7 @@
 #include <list.h>
 #include <hash.h>
 #include <stdint.h>
+#include "threads/fixed-point.h"
 #include "threads/synch.h"
 
 /* States in a thread's life cycle. */
@@ -26,6 +27,20 @@ typedef int tid_t;
 #define PRI_DEFAULT 31                  /* Default priority. */
 #define PRI_MAX 63                      /* Highest priority. */
 
+/* Thread niceness, for the MLFQS scheduler. */
+#define NICE_MIN -20                    /* Nicest to other threads. */
+#define NICE_DEFAULT 0                  /* Default niceness. */
+#define NICE_MAX 20                     /* Least nice. */
+
+/* A table of pointers indexed by small integer ids, such as file
+   descriptors, that grows as needed and hands out the lowest free
+   id. */
+struct id_table
+  {
+    void **slots;                       /* Indexed by id, null if free. */
+    struct bitmap *used;                /* Ids in use. */
+  };
+
 /* A kernel thread or user process.
 
    Each thread structure is stored in its own 4 kB page.  The
@@ -89,18 +104,35 @@ struct thread
     enum thread_status status;          /* Thread state. */
     char name[16];                      /* Name (for debugging purposes). */
     uint8_t *stack;                     /* Saved stack pointer. */
-    int priority;                       /* Priority. */
+    int priority;                       /* Priority, including donations. */
+    int base_priority;                  /* Priority without donations. */
     struct list_elem allelem;           /* List element for all threads list. */
 
-    /* Shared between thread.c and synch.c. */
+    /* Owned by synch.c. */
+    struct list locks;                  /* Locks held. */
+    struct lock *wait_lock;             /* Lock being waited for, if any. */
+
+    /* Used by the MLFQS scheduler. */
+    int nice;                           /* Niceness. */
+    fixed_point recent_cpu;             /* Recent CPU time received. */
+    bool charged;                       /* Charged CPU time since the
+                                           last priority update? */
+    struct list_elem charged_elem;      /* Element in charged_list. */
+
+    /* Shared between thread.c, synch.c and devices/timer.c. */
     struct list_elem elem;              /* List element. */
 
+    /* Owned by devices/timer.c. */
+    int64_t wakeup_tick;                /* Tick to wake at, if sleeping. */
+
 #ifdef USERPROG
     /* Owned by userprog/process.c. */
     uint32_t *pagedir;                  /* Page directory. */
 #endif
-    struct hash *pages;
+    struct page_table *pages;           /* Supplemental page table. */
     void *esp_track;
+    void *fault_last;                   /* Last page faulted or read ahead. */
+    int fault_run;                      /* Sequential faults in a row. */
 
     struct thread* parent;
     struct list_elem alive_child_elem;
@@ -112,13 +144,13 @@ struct thread
     struct semaphore waiting_sema;
     bool being_waited;
 
-    int file_open;
-    int max_fd;
-    int map_cnt;
-    int max_mapid;
-    struct list file_list;
-    struct list mapping_list;
+    struct id_table files;              /* Open files, by fd. */
+    struct id_table mappings;           /* Memory mappings, by mapid. */
+    struct list mapping_list;           /* Memory mappings, by address. */
     struct file* executable_file;
+    struct syscall_ring *ring;          /* Batched syscall ring, in user
+                                           memory, or null. */
+    struct dir *cwd;                    /* Current directory, null for root. */
 
     struct semaphore child_load;
     bool is_loaded;
@@ -162,6 +194,11 @@ void thread_foreach (thread_action_func *, void *);
 
 int thread_get_priority (void);
 void thread_set_priority (int);
+bool thread_priority_less (const struct list_elem *,
+                           const struct list_elem *, void *aux);
+void thread_preempt (void);
+void thread_donate_priority (struct thread *);
+void thread_update_priority (struct thread *);
 
 int thread_get_nice (void);
 void thread_set_nice (int);
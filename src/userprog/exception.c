@@ -161,8 +161,9 @@ page_fault (struct intr_frame *f)
    if((fault_addr==NULL)||(!is_user_vaddr(fault_addr))||(fault_addr<0x8048000))
       exit(-1);*/
    
-   if(not_present){
-      if (!page_fault_handler(fault_addr))
+   /* Writes to a present page may be to the shared zero page. */
+   if(not_present || write){
+      if (!page_fault_handler(fault_addr, write))
         exit(-1);
       return;
    }
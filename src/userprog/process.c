@@ -75,11 +75,14 @@ start_process (void *file_name_)
   struct intr_frame if_;
   bool success;
 
-  current_thread->pages = (struct hash*)malloc (sizeof (struct hash));
+  current_thread->pages = page_table_create ();
   if (current_thread->pages == NULL)
     exit(-1);
-  hash_init (current_thread->pages, page_hash, page_less, NULL);
 
+  /* The parent waits on child_load until we are done loading, so
+     its current directory cannot change under us. */
+  if (current_thread->parent->cwd != NULL)
+    current_thread->cwd = dir_reopen (current_thread->parent->cwd);
 
   /* Initialize interrupt frame and load executable. */
   memset (&if_, 0, sizeof if_);
@@ -529,7 +532,7 @@ setup_stack (void **esp,char * file_name)
   uint8_t *kpage;
   bool success = false;
 
-  success=new_page_alloc(PHYS_BASE- PGSIZE);
+  success=new_page_alloc(PHYS_BASE- PGSIZE, true);
   if (success)
     *esp = PHYS_BASE;
   else
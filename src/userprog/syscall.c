@@ -1,24 +1,39 @@
 #include "userprog/syscall.h"
+#include <limits.h>
 #include <stdio.h>
 #include <syscall-nr.h>
 #include <string.h>
 #include "threads/interrupt.h"
 #include "threads/thread.h"
 #include "threads/malloc.h"
+#include "threads/palloc.h"
 #include "threads/vaddr.h"
 #include "userprog/process.h"
 #include "filesys/file.h"
 #include "filesys/filesys.h"
+#include "filesys/inode.h"
 #include "userprog/pagedir.h"
 #include "threads/synch.h"
+#include <bitmap.h>
 
 static void syscall_handler (struct intr_frame *);
+static bool user_page_pin (const void *uaddr, bool write);
+static bool is_user_range (const void *vaddr, unsigned size);
+static int file_read_user (struct file *, void *buffer, unsigned length,
+                           off_t offset);
+static int file_write_user (struct file *, const void *buffer,
+                            unsigned length, off_t offset);
+static struct iovec *iovec_copy_in (const struct iovec *iov, int iovcnt);
+static int ring_execute (const struct ring_sqe *);
+static int id_table_add (struct id_table *, void *, size_t first);
+static void *id_table_get (struct id_table *, int id);
+static void id_table_remove (struct id_table *, int id);
+static void id_table_destroy (struct id_table *);
 
 void
 syscall_init (void) 
 {
   intr_register_int (0x30, 3, INTR_ON, syscall_handler, "syscall");
-  lock_init(&file_lock);
 }
 
 static void
@@ -76,6 +91,45 @@ syscall_handler (struct intr_frame *f)
     case SYS_MUNMAP:
       syscall_munmap(f);
       break;
+    case SYS_CHDIR:
+      syscall_chdir(f);
+      break;
+    case SYS_MKDIR:
+      syscall_mkdir(f);
+      break;
+    case SYS_READDIR:
+      syscall_readdir(f);
+      break;
+    case SYS_ISDIR:
+      syscall_isdir(f);
+      break;
+    case SYS_INUMBER:
+      syscall_inumber(f);
+      break;
+    case SYS_MSYNC:
+      syscall_msync(f);
+      break;
+    case SYS_PREAD:
+      syscall_pread(f);
+      break;
+    case SYS_PWRITE:
+      syscall_pwrite(f);
+      break;
+    case SYS_READV:
+      syscall_readv(f);
+      break;
+    case SYS_WRITEV:
+      syscall_writev(f);
+      break;
+    case SYS_RING_SETUP:
+      syscall_ring_setup(f);
+      break;
+    case SYS_RING_ENTER:
+      syscall_ring_enter(f);
+      break;
+    case SYS_SENDFILE:
+      syscall_sendfile(f);
+      break;
     default:
       exit(-1);
   }
@@ -85,20 +139,26 @@ void exit (int status){
   struct thread *current_thread=thread_current ();
   struct list_elem *tmp;
   struct thread_exit_status *tes;
+  size_t id;
   
-  if(lock_held_by_current_thread(&file_lock))
-    lock_release(&file_lock);
-  
-  for (tmp = list_begin (&current_thread->file_list); tmp != list_end (&current_thread->file_list); tmp = list_begin (&current_thread->file_list))
-    close (list_entry (tmp, struct process_file,elem)->fd);
+  if(current_thread->files.used!=NULL)
+    for (id = 0; id < bitmap_size (current_thread->files.used); id++)
+      if (current_thread->files.slots[id] != NULL)
+        close (id);
+  id_table_destroy (&current_thread->files);
 
-  for (tmp = list_begin (&current_thread->mapping_list); tmp != list_end (&current_thread->mapping_list); tmp = list_begin (&current_thread->mapping_list))
-    munmap (list_entry (tmp, struct process_mapping,elem)->mapid);
+  if(current_thread->mappings.used!=NULL)
+    for (id = 0; id < bitmap_size (current_thread->mappings.used); id++)
+      if (current_thread->mappings.slots[id] != NULL)
+        munmap (id);
+  id_table_destroy (&current_thread->mappings);
 
   if(current_thread->executable_file!=NULL){
     file_close(current_thread->executable_file);
     current_thread->executable_file=NULL;
   }
+  dir_close(current_thread->cwd);
+  current_thread->cwd=NULL;
     
   
   
@@ -152,11 +212,23 @@ int open (const char *file){
   }
 
   struct thread *current_thread = thread_current();
-  pf->fd = current_thread->max_fd;
-  current_thread->max_fd++;
-  current_thread->file_open++;
+  pf->fd = id_table_add(&current_thread->files,pf,2);
+  if(pf->fd < 0){
+    file_close(f);
+    free(pf);
+    return -1;
+  }
   pf->file = f;
-  list_push_back(&current_thread->file_list,&pf->elem);
+  pf->dir = NULL;
+  if(inode_is_dir(file_get_inode(f))){
+    pf->dir = dir_open(inode_reopen(file_get_inode(f)));
+    if(pf->dir == NULL){
+      id_table_remove(&current_thread->files,pf->fd);
+      file_close(f);
+      free(pf);
+      return -1;
+    }
+  }
   return pf->fd;
 }
 
@@ -171,10 +243,32 @@ int filesize (int fd){
 
 int read (int fd, void *buffer, unsigned length){
   if(fd==STDIN){
-    unsigned int i;
-    for(i=0;i<length;i++){
-      *((char **)buffer)[i] = input_getc();
+    /* Collect the keys a page at a time in a kernel buffer, so
+       that each user page is pinned once. */
+    uint8_t *kbuf;
+    char *dst=buffer;
+    unsigned left=length;
+
+    if(!is_user_range(buffer,length))
+      exit(-1);
+    kbuf=palloc_get_page(0);
+    if(kbuf==NULL)
+      return -1;
+    while(left>0){
+      unsigned chunk=PGSIZE-pg_ofs(dst);
+      unsigned i;
+      if(chunk>left)
+        chunk=left;
+      for(i=0;i<chunk;i++)
+        kbuf[i]=input_getc();
+      if(!copy_to_user(dst,kbuf,chunk)){
+        palloc_free_page(kbuf);
+        exit(-1);
+      }
+      dst+=chunk;
+      left-=chunk;
     }
+    palloc_free_page(kbuf);
     return length;
   }
   else if(fd==STDOUT){
@@ -185,13 +279,80 @@ int read (int fd, void *buffer, unsigned length){
     if(f == NULL){
       exit(-1);
     }
-    return (int) file_read(f->file,buffer,length);
+    if(f->dir != NULL)
+      return -1;
+
+    off_t pos=file_tell(f->file);
+    int n=file_read_user(f->file,buffer,length,pos);
+    file_seek(f->file,pos+n);
+    return n;
+  }
+}
+
+/* Reads LENGTH bytes from FILE at OFFSET into user BUFFER, a page
+   at a time, so that the file system never faults on the buffer
+   while holding its locks.  Returns the number of bytes read. */
+static int
+file_read_user (struct file *file, void *buffer, unsigned length,
+                off_t offset){
+  int total=0;
+  char *tmp=buffer;
+  while(length>0){
+    unsigned chunk=PGSIZE-pg_ofs(tmp);
+    if(chunk>length)
+      chunk=length;
+    if(!user_page_pin(tmp,true))
+      exit(-1);
+    off_t n=file_read_at(file,tmp,chunk,offset+total);
+    page_unpin(tmp);
+    total+=n;
+    if((unsigned) n<chunk)
+      break;
+    tmp+=n;
+    length-=n;
+  }
+  return total;
+}
+
+/* Writes LENGTH bytes from user BUFFER to FILE at OFFSET, as
+   file_read_user().  Returns the number of bytes written. */
+static int
+file_write_user (struct file *file, const void *buffer, unsigned length,
+                 off_t offset){
+  int total=0;
+  const char *tmp=buffer;
+  while(length>0){
+    unsigned chunk=PGSIZE-pg_ofs(tmp);
+    if(chunk>length)
+      chunk=length;
+    if(!user_page_pin(tmp,false))
+      exit(-1);
+    off_t n=file_write_at(file,tmp,chunk,offset+total);
+    page_unpin(tmp);
+    total+=n;
+    if((unsigned) n<chunk)
+      break;
+    tmp+=n;
+    length-=n;
   }
+  return total;
 }
 
 int write (int fd, const void *buffer, unsigned length){
   if(fd==STDOUT){
-    putbuf(buffer,length);
+    const char *src=buffer;
+    unsigned left=length;
+    while(left>0){
+      unsigned chunk=PGSIZE-pg_ofs(src);
+      if(chunk>left)
+        chunk=left;
+      if(!user_page_pin(src,false))
+        exit(-1);
+      putbuf(src,chunk);
+      page_unpin(src);
+      src+=chunk;
+      left-=chunk;
+    }
     return length;
   }
   else if(fd==STDIN){
@@ -202,8 +363,131 @@ int write (int fd, const void *buffer, unsigned length){
     if(f==NULL){
       exit(-1);
     }
-    return (int) file_write(f->file,buffer,length);
+    if(f->dir != NULL)
+      return -1;
+
+    off_t pos=file_tell(f->file);
+    int n=file_write_user(f->file,buffer,length,pos);
+    file_seek(f->file,pos+n);
+    return n;
+  }
+}
+
+/* Reads LENGTH bytes from FD at OFFSET into BUFFER without moving
+   FD's file position. */
+int pread (int fd, void *buffer, unsigned length, unsigned offset){
+  if(fd==STDIN || fd==STDOUT || (off_t) offset<0)
+    return -1;
+  struct process_file *f = get_process_file_by_fd(fd);
+  if(f == NULL){
+    exit(-1);
+  }
+  if(f->dir != NULL)
+    return -1;
+  return file_read_user(f->file,buffer,length,offset);
+}
+
+/* Writes LENGTH bytes from BUFFER to FD at OFFSET without moving
+   FD's file position. */
+int pwrite (int fd, const void *buffer, unsigned length, unsigned offset){
+  if(fd==STDIN || fd==STDOUT || (off_t) offset<0)
+    return -1;
+  struct process_file *f = get_process_file_by_fd(fd);
+  if(f == NULL){
+    exit(-1);
+  }
+  if(f->dir != NULL)
+    return -1;
+  return file_write_user(f->file,buffer,length,offset);
+}
+
+/* Copies the IOVCNT-element iovec array IOV from user memory and
+   checks that every buffer it describes lies in user space, so
+   that a bad pointer is caught before any transfer starts.  Kills
+   the process if any of it is invalid memory.  Returns NULL if IOVCNT is out of range or
+   the total length does not fit in an int.  The caller must free
+   the returned array. */
+static struct iovec *
+iovec_copy_in (const struct iovec *iov, int iovcnt){
+  struct iovec *kiov;
+  size_t total=0;
+  int i;
+
+  if(iovcnt<=0 || iovcnt>IOV_MAX)
+    return NULL;
+  kiov=malloc(iovcnt*sizeof *kiov);
+  if(kiov==NULL)
+    return NULL;
+  if(!copy_from_user(kiov,iov,iovcnt*sizeof *kiov)){
+    free(kiov);
+    exit(-1);
+  }
+  for(i=0;i<iovcnt;i++){
+    total+=kiov[i].iov_len;
+    if(kiov[i].iov_len>INT_MAX || total>INT_MAX){
+      free(kiov);
+      return NULL;
+    }
+    if(!is_user_range(kiov[i].iov_base,kiov[i].iov_len)){
+      free(kiov);
+      exit(-1);
+    }
+  }
+  return kiov;
+}
+
+/* Reads from FD into the IOVCNT buffers described by IOV, in
+   order, as one read() would.  Returns the number of bytes read,
+   or -1 on error. */
+int readv (int fd, const struct iovec *iov, int iovcnt){
+  struct iovec *kiov=iovec_copy_in(iov,iovcnt);
+  int total=0;
+  int i;
+
+  if(iovcnt==0)
+    return 0;
+  if(kiov==NULL)
+    return -1;
+  for(i=0;i<iovcnt;i++){
+    int n=read(fd,kiov[i].iov_base,kiov[i].iov_len);
+    if(n<0){
+      if(total==0)
+        total=-1;
+      break;
+    }
+    total+=n;
+    if((size_t) n<kiov[i].iov_len)
+      break;
+  }
+  free(kiov);
+  return total;
+}
+
+/* Writes to FD from the IOVCNT buffers described by IOV, in
+   order, as one write() would.  Returns the number of bytes
+   written, or -1 on error. */
+int writev (int fd, const struct iovec *iov, int iovcnt){
+  struct iovec *kiov=iovec_copy_in(iov,iovcnt);
+  int total=0;
+  int i;
+
+  if(iovcnt==0)
+    return 0;
+  if(kiov==NULL)
+    return -1;
+  for(i=0;i<iovcnt;i++){
+    int n=write(fd,kiov[i].iov_base,kiov[i].iov_len);
+    if(n<0){
+      if(total==0)
+        total=-1;
+      break;
+    }
+    total+=n;
+    if((size_t) n<kiov[i].iov_len)
+      break;
   }
+  free(kiov);
+  return total;
 }
 
 void seek (int fd, unsigned position){
@@ -231,16 +515,25 @@ void close (int fd){
   }
   
   file_close (pf->file);
-  list_remove (&pf->elem);
-  thread_current()->file_open--;
+  dir_close (pf->dir);
+  id_table_remove (&thread_current()->files, fd);
   free (pf);
 }
 
+/* Orders memory mappings by base address. */
+static bool
+mapping_less (const struct list_elem *a_, const struct list_elem *b_,
+              void *aux UNUSED){
+  const struct process_mapping *a = list_entry (a_, struct process_mapping, elem);
+  const struct process_mapping *b = list_entry (b_, struct process_mapping, elem);
+  return a->base < b->base;
+}
+
 mapid_t
 mmap (int fd, void *addr){
   struct thread *current_thread = thread_current();
   struct process_file *pf = get_process_file_by_fd(fd);
-  if(pf == NULL || pf->file==NULL){
+  if(pf == NULL || pf->file==NULL || pf->dir!=NULL){
     return -1;
   }
   if(addr==NULL || pg_ofs (addr) != 0){
@@ -255,46 +548,30 @@ mmap (int fd, void *addr){
     free (map);
     return -1;
   }
-  size_t offset=0;
   off_t length= file_length (map->file);
-  if(length==0){
-    free (map);
-    return -1;
-  }
+  if(length==0)
+    goto fail;
   int pg_cnt=length/PGSIZE;
   if(length%PGSIZE!=0)
     pg_cnt+=1;
-  for(int i=0;i<pg_cnt;i++){
-    if(find_page_by_vaddr(addr+i*PGSIZE)!=NULL){
-      free (map);
-      return -1;
-    }
-  }
+  if(!page_range_is_free(addr,pg_cnt))
+    goto fail;
 
-  map->mapid=current_thread->max_mapid++;
-  current_thread->map_cnt++;
+  /* Pages are created as they are faulted in. */
+  map->mapid=id_table_add(&current_thread->mappings,map,0);
+  if(map->mapid<0)
+    goto fail;
   map->base=addr;
-  map->page_cnt=0;
-  while(length>0){
-    struct page* p=page_alloc(addr + offset,true);
-    if (p == NULL){
-      free (map);
-      return -1;
-    }
-    p->writeback=true;
-    p->file = map->file;
-    p->file_offset = offset;
-    if(length >= PGSIZE)
-      p->file_bytes=PGSIZE;
-    else
-      p->file_bytes=length;
-    
-    offset += p->file_bytes;
-    length -= p->file_bytes;
-    map->page_cnt++;
-  }
-  list_push_back(&current_thread->mapping_list,&map->elem);
+  map->page_cnt=pg_cnt;
+  map->length=length;
+  list_insert_ordered(&current_thread->mapping_list,&map->elem,
+                      mapping_less,NULL);
   return map->mapid;
+
+ fail:
+  file_close (map->file);
+  free (map);
+  return -1;
 }
 
 void
@@ -304,19 +581,216 @@ munmap (mapid_t mapid){
     return -1;
   }
 
-  int i;
-  for(i=0;i<pm->page_cnt;i++){
-    if(pagedir_is_dirty(thread_current()->pagedir, pm->base + (PGSIZE * i))){
-      file_write_at(pm->file, pm->base + (PGSIZE * i), PGSIZE, PGSIZE * i);
-    }
-  }
+  page_writeback(pm->base, pm->page_cnt);
 
+  int i;
   for(i=0;i<pm->page_cnt;i++){
     page_free(pm->base + (PGSIZE * i));
   }
   list_remove(&pm->elem);
+  id_table_remove(&thread_current()->mappings,mapid);
+  file_close(pm->file);
   free(pm);
 }
+
+/* Writes the modified pages of mapping MAPID back to its file.
+   Returns 0 if successful, -1 if MAPID is not a mapping. */
+int
+msync (mapid_t mapid){
+  struct process_mapping* pm=get_process_mapping_by_mapid(mapid);
+  if(pm == NULL||pm->file==NULL)
+    return -1;
+  page_writeback(pm->base, pm->page_cnt);
+  return 0;
+}
+
+/* Registers RING, in user memory, for ring_enter(), replacing
+   any ring registered before.  A null RING unregisters.  Returns
+   false if RING's size is not a power of two no bigger than
+   RING_MAX_ENTRIES. */
+bool ring_setup (struct syscall_ring *ring){
+  struct syscall_ring r;
+
+  if(ring==NULL){
+    thread_current()->ring=NULL;
+    return true;
+  }
+  if(!copy_from_user(&r,ring,sizeof r))
+    exit(-1);
+  if(r.entries==0 || r.entries>RING_MAX_ENTRIES
+     || (r.entries & (r.entries-1))!=0)
+    return false;
+  thread_current()->ring=ring;
+  return true;
+}
+
+/* Executes up to TO_SUBMIT queued requests from the registered
+   ring, in order, writing each result to the completion queue.
+   Stops early when the submission queue runs dry or the
+   completion queue fills up.  Requests run synchronously, so all
+   of their completions are available on return.  Returns the
+   number of requests executed, or -1 if no ring is registered or
+   its indexes are corrupt. */
+int ring_enter (unsigned to_submit){
+  struct syscall_ring *uring=thread_current()->ring;
+  struct syscall_ring r;
+  unsigned done=0;
+
+  if(uring==NULL)
+    return -1;
+  if(!copy_from_user(&r,uring,sizeof r))
+    exit(-1);
+  if(r.entries==0 || (r.entries & (r.entries-1))!=0
+     || r.sq_tail-r.sq_head>r.entries || r.cq_tail-r.cq_head>r.entries)
+    return -1;
+
+  while(done<to_submit && r.sq_head!=r.sq_tail
+        && r.cq_tail-r.cq_head<r.entries){
+    uint32_t mask=r.entries-1;
+    struct ring_sqe sqe;
+    struct ring_cqe cqe;
+
+    if(!copy_from_user(&sqe,&r.sqes[r.sq_head & mask],sizeof sqe))
+      exit(-1);
+    cqe.user_data=sqe.user_data;
+    cqe.result=ring_execute(&sqe);
+    if(!copy_to_user(&r.cqes[r.cq_tail & mask],&cqe,sizeof cqe))
+      exit(-1);
+    r.sq_head++;
+    r.cq_tail++;
+    done++;
+  }
+
+  if(!copy_to_user(&uring->sq_head,&r.sq_head,sizeof r.sq_head)
+     || !copy_to_user(&uring->cq_tail,&r.cq_tail,sizeof r.cq_tail))
+    exit(-1);
+  return done;
+}
+
+/* Executes SQE with the same checks as the equivalent system
+   call and returns its result. */
+static int
+ring_execute (const struct ring_sqe *sqe){
+  switch(sqe->op){
+    case RING_READ:
+    case RING_PREAD:
+      return sqe->op==RING_READ
+             ? read(sqe->fd,sqe->buf,sqe->len)
+             : pread(sqe->fd,sqe->buf,sqe->len,sqe->offset);
+    case RING_WRITE:
+    case RING_PWRITE:
+      return sqe->op==RING_WRITE
+             ? write(sqe->fd,sqe->buf,sqe->len)
+             : pwrite(sqe->fd,sqe->buf,sqe->len,sqe->offset);
+    case RING_OPEN:
+      if(sqe->buf==NULL || !is_valid_addr(sqe->buf)
+         || !is_valid_string(sqe->buf))
+        exit(-1);
+      return open(sqe->buf);
+    case RING_CLOSE:
+      close(sqe->fd);
+      return 0;
+    case RING_SEEK:
+      seek(sqe->fd,sqe->offset);
+      return 0;
+    default:
+      return -1;
+  }
+}
+
+/* Copies COUNT bytes of IN_FD, starting at OFFSET, to OUT_FD at
+   its current position, or to the console if OUT_FD is STDOUT.
+   The data goes from the buffer cache through a kernel page and
+   never touches user memory.  IN_FD's position does not change.
+   Returns the number of bytes copied, which is less than COUNT
+   if IN_FD ends first, or -1 on error. */
+int sendfile (int out_fd, int in_fd, unsigned offset, unsigned count){
+  struct process_file *in, *out=NULL;
+
+  if(in_fd==STDIN || in_fd==STDOUT || out_fd==STDIN || (off_t) offset<0)
+    return -1;
+  in=get_process_file_by_fd(in_fd);
+  if(in==NULL){
+    exit(-1);
+  }
+  if(out_fd!=STDOUT){
+    out=get_process_file_by_fd(out_fd);
+    if(out==NULL){
+      exit(-1);
+    }
+    if(out->dir!=NULL)
+      return -1;
+  }
+  if(in->dir!=NULL)
+    return -1;
+  if(count>INT_MAX)
+    count=INT_MAX;
+
+  uint8_t *buffer=palloc_get_page(0);
+  if(buffer==NULL)
+    return -1;
+  int total=0;
+  while(count>0){
+    unsigned chunk=count<PGSIZE ? count : PGSIZE;
+    off_t n=file_read_at(in->file,buffer,chunk,offset+total);
+    off_t written;
+
+    if(n<=0)
+      break;
+    if(out==NULL){
+      putbuf((char *) buffer,n);
+      written=n;
+    }
+    else
+      written=file_write(out->file,buffer,n);
+    total+=written;
+    count-=written;
+    if(written<n || (unsigned) n<chunk)
+      break;
+  }
+  palloc_free_page(buffer);
+  return total;
+}
+
+bool chdir (const char *dir){
+  return filesys_chdir(dir);
+}
+
+bool mkdir (const char *dir){
+  return filesys_mkdir(dir);
+}
+
+bool readdir (int fd, char name[READDIR_MAX_LEN + 1]){
+  struct process_file *pf = get_process_file_by_fd(fd);
+  if(pf == NULL){
+    exit(-1);
+  }
+  if(pf->dir == NULL)
+    return false;
+
+  char entry[READDIR_MAX_LEN + 1];
+  if(!dir_readdir(pf->dir,entry))
+    return false;
+  if(!copy_to_user(name,entry,strlen(entry)+1))
+    exit(-1);
+  return true;
+}
+
+bool isdir (int fd){
+  struct process_file *pf = get_process_file_by_fd(fd);
+  if(pf == NULL){
+    exit(-1);
+  }
+  return pf->dir != NULL;
+}
+
+int inumber (int fd){
+  struct process_file *pf = get_process_file_by_fd(fd);
+  if(pf == NULL){
+    exit(-1);
+  }
+  return inode_get_inumber(file_get_inode(pf->file));
+}
 //↓ real system call function
 
 void syscall_halt (struct intr_frame* f){
@@ -342,10 +816,8 @@ void syscall_exec (struct intr_frame* f){
   char *new_cmd = (char*)malloc(strlen(cmd_line) + 1);
   strlcpy(new_cmd, cmd_line, strlen(cmd_line) + 1);
 
-  lock_acquire(&file_lock);
   f->eax = exec(new_cmd);
   free(new_cmd);
-  lock_release(&file_lock);
 }
 
 void syscall_wait (struct intr_frame* f){
@@ -365,9 +837,7 @@ void syscall_create (struct intr_frame* f){
     exit(-1);
   }
   unsigned size = *(int *)(f->esp+8);
-  lock_acquire(&file_lock);
   f->eax = create(file_name,size);
-  lock_release(&file_lock);
 }
 
 void syscall_remove (struct intr_frame* f){
@@ -378,9 +848,7 @@ void syscall_remove (struct intr_frame* f){
   if(file_name==NULL || !is_valid_addr(file_name) || !is_valid_string(file_name)){
     exit(-1);
   }
-  lock_acquire(&file_lock);
   f->eax = remove(file_name);
-  lock_release(&file_lock);
 }
 
 void syscall_open (struct intr_frame* f){
@@ -391,9 +859,7 @@ void syscall_open (struct intr_frame* f){
   if(file_name==NULL || !is_valid_addr(file_name) || !is_valid_string(file_name)){
     exit(-1);
   }
-  lock_acquire(&file_lock);
   f->eax = open(file_name);
-  lock_release(&file_lock);
 }
 
 void syscall_filesize (struct intr_frame* f){
@@ -401,9 +867,7 @@ void syscall_filesize (struct intr_frame* f){
     exit(-1);
   }
   int fd = *(int *)(f->esp + 4);
-  lock_acquire(&file_lock);
   f->eax = filesize(fd);
-  lock_release(&file_lock);
 }
 
 void syscall_read (struct intr_frame* f){
@@ -414,12 +878,7 @@ void syscall_read (struct intr_frame* f){
   void *buffer = *(char**)(f->esp + 8);
   unsigned size = *(unsigned *)(f->esp + 12);
 
-  if(!is_valid_buffer(buffer,size)){
-    exit(-1);
-  }
-  lock_acquire(&file_lock);
   f->eax = read(fd,buffer,size);
-  lock_release(&file_lock);
 }
 
 void syscall_write (struct intr_frame* f){
@@ -430,12 +889,7 @@ void syscall_write (struct intr_frame* f){
   void *buffer = *(char**)(f->esp + 8);
   unsigned size = *(unsigned *)(f->esp + 12);
 
-  if(!is_valid_buffer(buffer,size)){
-    exit(-1);
-  }
-  lock_acquire(&file_lock);
   f->eax=write(fd,buffer,size);
-  lock_release(&file_lock);
 }
 
 void syscall_seek (struct intr_frame* f){
@@ -444,9 +898,7 @@ void syscall_seek (struct intr_frame* f){
   }
   int fd = *(int *)(f->esp + 4);
   unsigned pos = *(unsigned *)(f->esp + 8);
-  lock_acquire(&file_lock);
   seek(fd,pos);
-  lock_release(&file_lock);
 }
 
 void syscall_tell (struct intr_frame* f){
@@ -454,9 +906,7 @@ void syscall_tell (struct intr_frame* f){
     exit(-1);
   }
   int fd = *(int *)(f->esp +4);
-  lock_acquire(&file_lock);
   f->eax =tell(fd);
-  lock_release(&file_lock);
 }
 
 void syscall_close (struct intr_frame* f){
@@ -464,9 +914,7 @@ void syscall_close (struct intr_frame* f){
     exit(-1);
   }
   int fd = *(int *)(f->esp +4);
-  lock_acquire(&file_lock);
   close(fd);
-  lock_release(&file_lock);
   
 }
 
@@ -476,9 +924,7 @@ void syscall_mmap (struct intr_frame* f){
   }
   int fd = *(int *)(f->esp +4);
   void* addr = *(void **)(f->esp +8);
-  lock_acquire(&file_lock);
   f->eax =mmap(fd,addr);
-  lock_release(&file_lock);
   
 }
 
@@ -487,32 +933,220 @@ void syscall_munmap (struct intr_frame* f){
     exit(-1);
   }
   mapid_t mapid = *(int *)(f->esp +4);
-  lock_acquire(&file_lock);
   munmap(mapid);
-  lock_release(&file_lock);
 }
 
+void syscall_msync (struct intr_frame* f){
+  if(!is_valid_buffer(f->esp+4,4)){
+    exit(-1);
+  }
+  mapid_t mapid = *(int *)(f->esp +4);
+  f->eax = msync(mapid);
+}
+
+void syscall_pread (struct intr_frame* f){
+  if(!is_valid_buffer(f->esp+4,16)){
+    exit(-1);
+  }
+  int fd = *(int *)(f->esp +4);
+  void *buffer = *(char**)(f->esp + 8);
+  unsigned size = *(unsigned *)(f->esp + 12);
+  unsigned offset = *(unsigned *)(f->esp + 16);
+
+  f->eax = pread(fd,buffer,size,offset);
+}
+
+void syscall_pwrite (struct intr_frame* f){
+  if(!is_valid_buffer(f->esp+4,16)){
+    exit(-1);
+  }
+  int fd = *(int *)(f->esp +4);
+  void *buffer = *(char**)(f->esp + 8);
+  unsigned size = *(unsigned *)(f->esp + 12);
+  unsigned offset = *(unsigned *)(f->esp + 16);
+
+  f->eax = pwrite(fd,buffer,size,offset);
+}
+
+void syscall_readv (struct intr_frame* f){
+  if(!is_valid_buffer(f->esp+4,12)){
+    exit(-1);
+  }
+  int fd = *(int *)(f->esp +4);
+  const struct iovec *iov = *(struct iovec **)(f->esp + 8);
+  int iovcnt = *(int *)(f->esp + 12);
+  f->eax = readv(fd,iov,iovcnt);
+}
+
+void syscall_writev (struct intr_frame* f){
+  if(!is_valid_buffer(f->esp+4,12)){
+    exit(-1);
+  }
+  int fd = *(int *)(f->esp +4);
+  const struct iovec *iov = *(struct iovec **)(f->esp + 8);
+  int iovcnt = *(int *)(f->esp + 12);
+  f->eax = writev(fd,iov,iovcnt);
+}
+
+void syscall_ring_setup (struct intr_frame* f){
+  if(!is_valid_buffer(f->esp+4,4)){
+    exit(-1);
+  }
+  struct syscall_ring *ring = *(struct syscall_ring **)(f->esp + 4);
+  f->eax = ring_setup(ring);
+}
+
+void syscall_ring_enter (struct intr_frame* f){
+  if(!is_valid_buffer(f->esp+4,4)){
+    exit(-1);
+  }
+  unsigned to_submit = *(unsigned *)(f->esp + 4);
+  f->eax = ring_enter(to_submit);
+}
+
+void syscall_sendfile (struct intr_frame* f){
+  if(!is_valid_buffer(f->esp+4,16)){
+    exit(-1);
+  }
+  int out_fd = *(int *)(f->esp + 4);
+  int in_fd = *(int *)(f->esp + 8);
+  unsigned offset = *(unsigned *)(f->esp + 12);
+  unsigned count = *(unsigned *)(f->esp + 16);
+  f->eax = sendfile(out_fd,in_fd,offset,count);
+}
+
+void syscall_chdir (struct intr_frame* f){
+  if(!is_valid_buffer(f->esp+4,4)){
+    exit(-1);
+  }
+  char* dir = *(char **)(f->esp+4);
+  if(dir==NULL || !is_valid_addr(dir) || !is_valid_string(dir)){
+    exit(-1);
+  }
+  f->eax = chdir(dir);
+}
+
+void syscall_mkdir (struct intr_frame* f){
+  if(!is_valid_buffer(f->esp+4,4)){
+    exit(-1);
+  }
+  char* dir = *(char **)(f->esp+4);
+  if(dir==NULL || !is_valid_addr(dir) || !is_valid_string(dir)){
+    exit(-1);
+  }
+  f->eax = mkdir(dir);
+}
+
+void syscall_readdir (struct intr_frame* f){
+  if(!is_valid_buffer(f->esp+4,8)){
+    exit(-1);
+  }
+  int fd = *(int *)(f->esp +4);
+  char* name = *(char **)(f->esp+8);
+  if(!is_valid_buffer(name,READDIR_MAX_LEN + 1)){
+    exit(-1);
+  }
+  f->eax = readdir(fd,name);
+}
+
+void syscall_isdir (struct intr_frame* f){
+  if(!is_valid_buffer(f->esp+4,4)){
+    exit(-1);
+  }
+  int fd = *(int *)(f->esp +4);
+  f->eax = isdir(fd);
+}
+
+void syscall_inumber (struct intr_frame* f){
+  if(!is_valid_buffer(f->esp+4,4)){
+    exit(-1);
+  }
+  int fd = *(int *)(f->esp +4);
+  f->eax = inumber(fd);
+}
+
+
+/* Stores PTR in table T under the lowest free id not less than
+   FIRST, growing T if it is full.  Returns the id, or -1 if out
+   of memory. */
+static int
+id_table_add (struct id_table *t, void *ptr, size_t first)
+{
+  size_t size = t->used != NULL ? bitmap_size (t->used) : 0;
+  size_t id = size > first
+              ? bitmap_scan_and_flip (t->used, first, 1, false)
+              : BITMAP_ERROR;
+
+  if (id == BITMAP_ERROR)
+    {
+      /* Full: double the table. */
+      size_t new_size = size > 0 ? size * 2 : 16;
+      struct bitmap *used;
+      void **slots;
+      size_t i;
+
+      while (new_size <= first)
+        new_size *= 2;
+      used = bitmap_create (new_size);
+      if (used == NULL)
+        return -1;
+      slots = realloc (t->slots, new_size * sizeof *slots);
+      if (slots == NULL)
+        {
+          bitmap_destroy (used);
+          return -1;
+        }
+      for (i = 0; i < size; i++)
+        bitmap_set (used, i, bitmap_test (t->used, i));
+      for (i = size; i < new_size; i++)
+        slots[i] = NULL;
+      if (t->used != NULL)
+        bitmap_destroy (t->used);
+      t->used = used;
+      t->slots = slots;
+      id = bitmap_scan_and_flip (t->used, first, 1, false);
+    }
+  t->slots[id] = ptr;
+  return id;
+}
+
+/* Returns the pointer stored under ID in T, or NULL if none. */
+static void *
+id_table_get (struct id_table *t, int id)
+{
+  if (id < 0 || t->used == NULL || (size_t) id >= bitmap_size (t->used))
+    return NULL;
+  return t->slots[id];
+}
+
+/* Frees ID in T. */
+static void
+id_table_remove (struct id_table *t, int id)
+{
+  ASSERT (id_table_get (t, id) != NULL);
+  t->slots[id] = NULL;
+  bitmap_reset (t->used, id);
+}
+
+/* Frees T's storage, leaving it empty. */
+static void
+id_table_destroy (struct id_table *t)
+{
+  if (t->used != NULL)
+    bitmap_destroy (t->used);
+  free (t->slots);
+  t->used = NULL;
+  t->slots = NULL;
+}
 
 struct process_file*
 get_process_file_by_fd(int fd){
-  struct thread *current_thread=thread_current ();
-  struct list_elem *tmp;
-  for (tmp = list_begin (&current_thread->file_list); tmp != list_end (&current_thread->file_list); tmp = list_next (tmp)){
-    if(list_entry (tmp, struct process_file, elem)->fd== fd)
-      return list_entry (tmp, struct process_file, elem);
-  }
-  return NULL;
+  return id_table_get (&thread_current ()->files, fd);
 }
 
 struct process_mapping*
 get_process_mapping_by_mapid(mapid_t mapid){
-  struct thread *current_thread=thread_current ();
-  struct list_elem *tmp;
-  for (tmp = list_begin (&current_thread->mapping_list); tmp != list_end (&current_thread->mapping_list); tmp = list_next (tmp)){
-    if(list_entry (tmp, struct process_mapping, elem)->mapid== mapid)
-      return list_entry (tmp, struct process_mapping, elem);
-  }
-  return NULL;
+  return id_table_get (&thread_current ()->mappings, mapid);
 }
 
 bool
@@ -520,23 +1154,104 @@ is_valid_addr(const void *vaddr){
   if((vaddr==NULL)||(!is_user_vaddr(vaddr))||(vaddr<0x8048000))
     return false;
 	if (!(pagedir_get_page(thread_current()->pagedir, vaddr))){
-    if (!page_fault_handler(vaddr))
+    if (!page_fault_handler(vaddr, false))
       exit(-1);
 		return true;
 	}
 	return true;
 }
 
+/* Checks that the SIZE bytes at VADDR are valid user memory,
+   faulting in any page that is not present.  One check per page
+   spanned suffices, since validity is per page. */
 bool
 is_valid_buffer (void *vaddr, unsigned size)
 {
-  unsigned i;
   char* tmp=vaddr;
-  for (i = 0; i < size; i++){
+  char* end=tmp+size;
+
+  if(end<tmp)
+    return false;
+  while(tmp<end){
     if(!is_valid_addr(tmp)){
       return false;
     }
-    tmp++;
+    tmp=(char *)pg_round_down(tmp)+PGSIZE;
+  }
+  return true;
+}
+
+/* Checks that the SIZE bytes at VADDR lie in user space above the
+   code segment.  Unlike is_valid_buffer(), does not touch or fault
+   in the pages; user_page_pin() validates each one when it is
+   used. */
+static bool
+is_user_range (const void *vaddr, unsigned size)
+{
+  const char *start=vaddr;
+  const char *end=start+size;
+
+  if(size==0)
+    return true;
+  return start>=(const char *)0x8048000 && end>start
+         && is_user_vaddr(end-1);
+}
+
+/* Pins the user page containing UADDR with page_pin(), after
+   rejecting null pointers and addresses below the code segment.
+   page_pin() itself rejects kernel addresses. */
+static bool
+user_page_pin (const void *uaddr, bool write)
+{
+  if(uaddr==NULL || uaddr<(void *)0x8048000)
+    return false;
+  return page_pin(uaddr,write);
+}
+
+/* Copies SIZE bytes from user address USRC to DST, a page at a
+   time, each user page pinned while it is read.  Returns false
+   if USRC is not valid user memory. */
+bool
+copy_from_user (void *dst, const void *usrc, size_t size)
+{
+  uint8_t *kdst=dst;
+  const uint8_t *usrc_=usrc;
+
+  while(size>0){
+    size_t chunk=PGSIZE-pg_ofs(usrc_);
+    if(chunk>size)
+      chunk=size;
+    if(!user_page_pin(usrc_,false))
+      return false;
+    memcpy(kdst,usrc_,chunk);
+    page_unpin(usrc_);
+    kdst+=chunk;
+    usrc_+=chunk;
+    size-=chunk;
+  }
+  return true;
+}
+
+/* Copies SIZE bytes from SRC to user address UDST, a page at a
+   time, each user page pinned while it is written.  Returns
+   false if UDST is not valid, writable user memory. */
+bool
+copy_to_user (void *udst, const void *src, size_t size)
+{
+  uint8_t *udst_=udst;
+  const uint8_t *ksrc=src;
+
+  while(size>0){
+    size_t chunk=PGSIZE-pg_ofs(udst_);
+    if(chunk>size)
+      chunk=size;
+    if(!user_page_pin(udst_,true))
+      return false;
+    memcpy(udst_,ksrc,chunk);
+    page_unpin(udst_);
+    udst_+=chunk;
+    ksrc+=chunk;
+    size-=chunk;
   }
   return true;
 }
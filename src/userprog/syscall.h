@@ -4,8 +4,10 @@
 #include <stdbool.h>
 #include <debug.h>
 #include <list.h>
+#include "filesys/directory.h"
 #include "filesys/file.h"
 #include "vm/page.h"
+#include <syscall-ring.h>
 /* Process identifier. */
 typedef int pid_t;
 #define PID_ERROR ((pid_t) -1)
@@ -17,6 +19,15 @@ typedef int mapid_t;
 /* Maximum characters in a filename written by readdir(). */
 #define READDIR_MAX_LEN 14
 
+/* One buffer of a readv() or writev() call. */
+struct iovec{
+    void *iov_base;             /* Start of buffer. */
+    size_t iov_len;             /* Size of buffer in bytes. */
+};
+
+/* Maximum number of buffers in one readv() or writev() call. */
+#define IOV_MAX 1024
+
 /* Typical return values from main() and arguments to exit(). */
 #define EXIT_SUCCESS 0          /* Successful execution. */
 #define EXIT_FAILURE 1          /* Unsuccessful execution. */
@@ -27,19 +38,20 @@ typedef int mapid_t;
 struct process_file{
     int fd;
     struct file *file;
-    struct list_elem elem;
+    struct dir *dir;
 };
 
+/* A memory-mapped region.  Its pages are created only when
+   first touched, by page_fault_handler(). */
 struct process_mapping{
     int mapid;
     struct file *file;
     void *base;
     size_t page_cnt;
-    struct list_elem elem;
+    off_t length;               /* File length when mapped. */
+    struct list_elem elem;      /* In mapping_list, sorted by base. */
 };
 
-struct lock file_lock;
-
 
 void syscall_init (void);
 
@@ -57,7 +69,20 @@ unsigned tell (int fd);
 void close (int fd);
 mapid_t mmap (int fd, void *addr);
 void munmap (mapid_t);
-/*
+int msync (mapid_t);
+int pread (int fd, void *buffer, unsigned length, unsigned offset);
+int pwrite (int fd, const void *buffer, unsigned length, unsigned offset);
+int readv (int fd, const struct iovec *iov, int iovcnt);
+int writev (int fd, const struct iovec *iov, int iovcnt);
+bool ring_setup (struct syscall_ring *ring);
+int ring_enter (unsigned to_submit);
+int sendfile (int out_fd, int in_fd, unsigned offset, unsigned count);
+bool chdir (const char *dir);
+bool mkdir (const char *dir);
+bool readdir (int fd, char name[READDIR_MAX_LEN + 1]);
+bool isdir (int fd);
+int inumber (int fd);
+
 void syscall_halt (struct intr_frame* f);
 void syscall_exit (struct intr_frame* f);
 void syscall_exec (struct intr_frame* f);
@@ -71,12 +96,29 @@ void syscall_write (struct intr_frame* f);
 void syscall_seek (struct intr_frame* f);
 void syscall_tell (struct intr_frame* f);
 void syscall_close (struct intr_frame* f);
-*/
+void syscall_mmap (struct intr_frame* f);
+void syscall_munmap (struct intr_frame* f);
+void syscall_msync (struct intr_frame* f);
+void syscall_pread (struct intr_frame* f);
+void syscall_pwrite (struct intr_frame* f);
+void syscall_readv (struct intr_frame* f);
+void syscall_writev (struct intr_frame* f);
+void syscall_ring_setup (struct intr_frame* f);
+void syscall_ring_enter (struct intr_frame* f);
+void syscall_sendfile (struct intr_frame* f);
+void syscall_chdir (struct intr_frame* f);
+void syscall_mkdir (struct intr_frame* f);
+void syscall_readdir (struct intr_frame* f);
+void syscall_isdir (struct intr_frame* f);
+void syscall_inumber (struct intr_frame* f);
+
 struct process_file* get_process_file_by_fd(int fd);
 struct process_mapping* get_process_mapping_by_mapid(mapid_t mapid);
 bool is_valid_addr(const void *vaddr);
 bool is_valid_buffer (void *vaddr, unsigned size);
 bool is_valid_string(void *str);
+bool copy_from_user (void *dst, const void *usrc, size_t size);
+bool copy_to_user (void *udst, const void *src, size_t size);
 static int get_user (const uint8_t *uaddr);
 static bool put_user (uint8_t *udst, uint8_t byte);
 
@@ -1,103 +1,263 @@
 #include "vm/frame.h"
+#include "filesys/inode.h"
 
-struct list frames;
-struct list_elem* frames_ptr;
+/* Frame table, with one entry per page in the user pool, indexed
+   by the page's position in the pool.  An entry whose page is
+   NULL is not in use. */
+static struct frame *frame_table;
+static size_t frame_cnt;
+static size_t frame_used_cnt;   /* Entries in use. */
+
+/* Clock hand for frame_find_victim(). */
+static size_t clock_hand;
+
+/* Shared frames, keyed by inode, offset and number of file bytes,
+   protected by evict_lock.  Two mappings of the same offset that
+   read different amounts of the file, e.g. the last page of one
+   segment and a middle page of another, differ in their zero-filled
+   tails and must not share. */
+static struct hash share_table;
+
+static hash_hash_func share_hash;
+static hash_less_func share_less;
 
 struct lock frame_lock;
 void
 frame_init () 
 {
-    list_init(&frames);
+    frame_cnt = palloc_user_page_cnt();
+    frame_table = calloc(frame_cnt, sizeof(struct frame));
+    if(frame_table == NULL && frame_cnt > 0)
+        PANIC ("OOM allocating frame table");
+    clock_hand = 0;
+    frame_used_cnt = 0;
     lock_init (&frame_lock);
-    frames_ptr=NULL;
+    hash_init (&share_table, share_hash, share_less, NULL);
 }
 
+/* Returns the frame table entry for KPAGE, a page from the user
+   pool, now holding page P of the current thread.  The frame
+   starts out pinned, so that it is not evicted before the caller
+   has filled and mapped it; call frame_unpin() when done. */
 struct frame *
-frame_alloc(){
-    struct frame *f = (struct frame *)malloc (sizeof(struct frame));
-    if(f == NULL)
-        PANIC ("OOM allocating frame table");
-    f->base=NULL;
-    f->page=NULL;
-    f->thread=thread_current();
+frame_alloc(void *kpage, struct page *p){
+    struct frame *f = &frame_table[palloc_user_page_idx(kpage)];
     lock_acquire(&frame_lock);
-    if(list_empty(&frames))
-        frames_ptr=&f->elem;
-    list_push_back(&frames,&f->elem);
-    if(frames_ptr==NULL || frames_ptr==list_end (&frames))
-        frames_ptr=list_begin(&frames);
+    ASSERT (f->page == NULL);
+    f->base=kpage;
+    f->page=p;
+    f->thread=thread_current();
+    f->pin_cnt=1;
+    f->evicting=false;
+    f->inode=NULL;
+    f->share_cnt=0;
+    frame_used_cnt++;
     lock_release(&frame_lock);
     return f;
 }
 
+/* Keeps F from being evicted until a matching frame_unpin().
+   Pins nest, so that a shared frame can be pinned by several
+   processes at once. */
+void
+frame_pin(struct frame *f){
+    lock_acquire(&frame_lock);
+    f->pin_cnt++;
+    lock_release(&frame_lock);
+}
+
+/* Pins the frame holding P and returns true, if P is in memory
+   and not being evicted.  Otherwise returns false at once.  Only
+   frame_lock is taken, which is never held across disk I/O, so
+   this does not wait behind eviction. */
+bool
+frame_pin_page(struct page *p){
+    struct frame *f;
+    bool pinned;
+
+    lock_acquire(&frame_lock);
+    f=p->frame;
+    pinned=f!=NULL && !f->evicting;
+    if(pinned)
+        f->pin_cnt++;
+    lock_release(&frame_lock);
+    return pinned;
+}
+
+/* Drops one pin on F, allowing it to be evicted again once no
+   pins remain. */
+void
+frame_unpin(struct frame *f){
+    lock_acquire(&frame_lock);
+    ASSERT (f->pin_cnt > 0);
+    f->pin_cnt--;
+    lock_release(&frame_lock);
+}
+
+/* Marks F unused.  Must be called before F's page goes back to
+   palloc, since the page may be handed out again right away. */
 void
 frame_free(struct frame * f){
     lock_acquire(&frame_lock);
-    if(frames_ptr==&f->elem)
-        frames_ptr=list_next (&f->elem);
-    list_remove(&f->elem);
-    if(list_empty(&frames))
-        frames_ptr=NULL;
-    else if(frames_ptr==list_end (&frames))
-        frames_ptr=list_begin(&frames);
-    free(f);
+    f->page=NULL;
+    f->pin_cnt=0;
+    f->evicting=false;
+    frame_used_cnt--;
     lock_release(&frame_lock);
 }
 
+/* Returns the number of frame table entries not in use. */
+size_t
+frame_free_cnt(void){
+    return frame_cnt - frame_used_cnt;
+}
+
+/* Returns the total number of frames. */
+size_t
+frame_total_cnt(void){
+    return frame_cnt;
+}
+
+/* Returns a hash value for shared frame E. */
+static unsigned
+share_hash (const struct hash_elem *e, void *aux UNUSED)
+{
+    const struct frame *f = hash_entry (e, struct frame, share_elem);
+    return (hash_bytes (&f->inode, sizeof f->inode) ^ hash_int (f->offset)
+            ^ hash_int (f->file_bytes));
+}
+
+/* Returns true if shared frame A precedes shared frame B. */
+static bool
+share_less (const struct hash_elem *a_, const struct hash_elem *b_,
+            void *aux UNUSED)
+{
+    const struct frame *a = hash_entry (a_, struct frame, share_elem);
+    const struct frame *b = hash_entry (b_, struct frame, share_elem);
+
+    if (a->inode != b->inode)
+        return a->inode < b->inode;
+    if (a->offset != b->offset)
+        return a->offset < b->offset;
+    return a->file_bytes < b->file_bytes;
+}
+
+/* Returns the shared frame holding FILE_BYTES bytes at OFFSET in
+   INODE followed by zeros, or NULL if there is none.  evict_lock
+   must be held. */
+struct frame *
+frame_share_lookup(struct inode *inode, off_t offset, off_t file_bytes){
+    struct frame key;
+    struct hash_elem *e;
+
+    key.inode=inode;
+    key.offset=offset;
+    key.file_bytes=file_bytes;
+    e=hash_find(&share_table,&key.share_elem);
+    return e!=NULL ? hash_entry(e,struct frame,share_elem) : NULL;
+}
+
+/* Makes F, a private frame holding FILE_BYTES bytes at OFFSET in
+   INODE followed by zeros, available for other processes to
+   share.  F's page becomes its first sharer.  evict_lock must be
+   held. */
+void
+frame_share(struct frame *f, struct inode *inode, off_t offset,
+            off_t file_bytes){
+    ASSERT (f->inode == NULL);
+
+    /* Keep the inode alive as long as it is our key. */
+    f->inode=inode_reopen(inode);
+    f->offset=offset;
+    f->file_bytes=file_bytes;
+    list_init(&f->sharers);
+    list_push_back(&f->sharers,&f->page->share_elem);
+    f->share_cnt=1;
+    hash_insert(&share_table,&f->share_elem);
+}
+
+/* Adds P to the pages sharing F.  evict_lock must be held. */
+void
+frame_share_attach(struct frame *f, struct page *p){
+    ASSERT (f->inode != NULL);
+
+    list_push_back(&f->sharers,&p->share_elem);
+    f->share_cnt++;
+}
+
+/* Removes P from the pages sharing F.  Returns true if P was the
+   last sharer, in which case F is no longer shared and the caller
+   must free it.  evict_lock must be held. */
+bool
+frame_share_detach(struct frame *f, struct page *p){
+    ASSERT (f->inode != NULL && f->share_cnt > 0);
+
+    list_remove(&p->share_elem);
+    f->share_cnt--;
+    if(f->share_cnt==0){
+        hash_delete(&share_table,&f->share_elem);
+        inode_close(f->inode);
+        f->inode=NULL;
+        return true;
+    }
+    if(f->page==p){
+        struct page *q=list_entry(list_front(&f->sharers),struct page,
+                                  share_elem);
+        f->page=q;
+        f->thread=q->thread;
+    }
+    return false;
+}
+
+/* Returns true if F was accessed through any of its mappings
+   since the last call, and clears the accessed bits. */
+static bool
+frame_test_and_clear_accessed(struct frame *f){
+    struct list_elem *e;
+    bool accessed=false;
+
+    if(f->inode==NULL){
+        accessed=pagedir_is_accessed (f->thread->pagedir, f->page->upage);
+        pagedir_set_accessed(f->thread->pagedir, f->page->upage,false);
+        return accessed;
+    }
+    for(e=list_begin(&f->sharers);e!=list_end(&f->sharers);e=list_next(e)){
+        struct page *q=list_entry(e,struct page,share_elem);
+        if(pagedir_is_accessed(q->thread->pagedir,q->upage)){
+            pagedir_set_accessed(q->thread->pagedir,q->upage,false);
+            accessed=true;
+        }
+    }
+    return accessed;
+}
+
+/* Chooses a frame to evict with the second-chance clock
+   algorithm: the hand sweeps the table once per frame, sparing
+   and clearing the accessed bit of frames used since it last
+   passed.  After two sweeps every frame has lost its second
+   chance, so the search is bounded.  The victim is returned
+   marked evicting, so that no other thread picks or pins it too.
+   Returns NULL if every frame is free, pinned or already being
+   evicted.  evict_lock must be held. */
 struct frame *
 frame_find_victim(){
+    struct frame *victim=NULL;
+    size_t i;
+
     lock_acquire (&frame_lock);
+    for(i=0;i<2*frame_cnt;i++){
+        struct frame *f=&frame_table[clock_hand];
+        clock_hand=(clock_hand+1)%frame_cnt;
 
-    struct list_elem* e;
-    struct frame *f;
-    bool access,dirty;
-    size_t len=list_size(&frames);
-    if(len==0 || frames_ptr==NULL)
-        return NULL;
-    size_t i;
-    int j;
-    for(j=0;j<2;j++){
-        for(i=0,e=frames_ptr;i<len;e=list_next (e),i++){
-            if(e == list_end (&frames))
-                e = list_begin (&frames);
-    
-            f=list_entry(e,struct frame,elem);
-            access=pagedir_is_accessed (f->thread->pagedir, f->page->upage);
-            dirty=pagedir_is_dirty(f->thread->pagedir, f->page->upage);
-    
-            if(!access && !dirty){
-                frames_ptr=list_next (frames_ptr);
-                list_remove(e);
-                if(frames_ptr==list_end (&frames))
-                    frames_ptr=list_begin(&frames);
-
-                lock_release(&frame_lock);
-                return f;
-            }
-        }
-    
-        for(i=0,e=frames_ptr;i<len;e=list_next (e),i++){
-            if(e == list_end (&frames))
-                e = list_begin (&frames);
-    
-            f=list_entry(e,struct frame,elem);
-            access=pagedir_is_accessed (f->thread->pagedir, f->page->upage);
-            dirty=pagedir_is_dirty(f->thread->pagedir, f->page->upage);
-    
-            if(!access && dirty){
-                frames_ptr=list_next (frames_ptr);
-                list_remove(e);
-                if(frames_ptr==list_end (&frames))
-                    frames_ptr=list_begin(&frames);
-
-                lock_release(&frame_lock);
-                return f;
-            }
-            else{
-                pagedir_set_accessed(f->thread->pagedir, f->page->upage,false);
-            }
-        }
+        if(f->page==NULL || f->pin_cnt>0 || f->evicting
+           || f->thread->pagedir==NULL)
+            continue;
+        if(frame_test_and_clear_accessed(f))
+            continue;
+        victim=f;
+        victim->evicting=true;
+        break;
     }
     lock_release(&frame_lock);
-    return  NULL;
-}
\ No newline at end of file
+    return victim;
+}
@@ -2,6 +2,7 @@
 #define VM_FRAME_H
 
 #include "threads/synch.h"
+#include <hash.h>
 #include <list.h>
 #include <stdio.h>
 #include "vm/page.h"
@@ -12,21 +13,46 @@
 #include "threads/synch.h"
 #include "threads/vaddr.h"
 #include "threads/thread.h"
+#include "filesys/off_t.h"
 #include "userprog/pagedir.h"
 
 
 struct frame {
     void* base;            /* kernel virtual base address */
     struct thread* thread; /* thread which owns this frame */
-    struct page* page;     /* page corresponding to this frame */
-    struct list_elem elem;
+    struct page* page;     /* page corresponding to this frame, or NULL if free */
+    int pin_cnt;           /* not to be evicted while nonzero */
+    bool evicting;         /* claimed by the evictor, page in transit */
+
+    /* Read-only file pages are shared by every process that maps
+       the same page of the same file.  PAGE and THREAD then name
+       one of the sharers.  All of these are protected by
+       evict_lock. */
+    struct inode *inode;   /* file the page comes from, or NULL if private */
+    off_t offset;          /* offset of the page in the file */
+    off_t file_bytes;      /* bytes read from the file, rest zeros */
+    struct list sharers;   /* pages mapping this frame, via share_elem */
+    int share_cnt;         /* number of sharers */
+    struct hash_elem share_elem;  /* element in the shared page table */
 };
 
 void frame_init ();
 
-struct frame* frame_alloc();
+struct frame* frame_alloc(void *kpage, struct page *p);
+void frame_pin(struct frame *f);
+bool frame_pin_page(struct page *p);
+void frame_unpin(struct frame *f);
 void frame_free(struct frame * f);
 
 struct frame* frame_find_victim();
+size_t frame_free_cnt(void);
+size_t frame_total_cnt(void);
+
+struct frame* frame_share_lookup(struct inode *inode, off_t offset,
+                                 off_t file_bytes);
+void frame_share(struct frame *f, struct inode *inode, off_t offset,
+                 off_t file_bytes);
+void frame_share_attach(struct frame *f, struct page *p);
+bool frame_share_detach(struct frame *f, struct page *p);
 
 #endif
\ No newline at end of file
@@ -8,31 +8,166 @@
 #include "threads/thread.h"
 #include "userprog/pagedir.h"
 #include "threads/vaddr.h"
+#include "threads/pte.h"
+
+static void *page_get_kpage (void);
+static size_t page_evict (size_t max);
+static bool page_load (struct page *, void *kpage);
+static bool page_load_shared (struct page *, void *kpage);
+static void page_unshare (struct page *);
+static void page_evict_shared (struct frame *);
+static void page_wait_transit (struct page *);
+static bool page_map_zero (struct page *);
+static struct page *mapping_page_alloc (const void *vaddr);
+static void page_fault_ahead (struct page *);
+static void page_read_around (struct page *, block_sector_t sector);
+static void pageout_daemon (void *aux);
+
+/* Free frame watermarks in effect, and the semaphore that wakes
+   the page-out daemon. */
+static size_t pageout_low;
+static size_t pageout_high;
+static struct semaphore pageout_sema;
+
+/* Pages being written out by an evicting thread are "in transit":
+   their frames are unmapped and marked evicting, but still theirs
+   until the write finishes.  evict_lock is not held during the
+   write.  Threads that need such a page wait on transit_cond,
+   which goes with evict_lock. */
+static struct condition transit_cond;
+static size_t transit_cnt;      /* Pages in transit. */
+
+/* A page of zeros, mapped read-only wherever an anonymous page is
+   read before it is first written.  It is not in the user pool,
+   so it never appears in the frame table and is never evicted. */
+static void *zero_page;
+
+/* Page descriptors are carved out of whole kernel pages instead
+   of being malloc'd one at a time, and recycled through a free
+   list threaded through the unused descriptors. */
+struct free_page_desc {
+    struct free_page_desc *next;
+};
+static struct free_page_desc *page_desc_free_list;
+static struct lock page_desc_lock;
 
 /* Maximum pages of stack, in bytes. */
 /* Right now it is 8 megabyte. */
 #define STACK_PAGE_MAX 2048
 
+/* Returns a new, uninitialized page descriptor. */
+static struct page *
+page_desc_alloc (void)
+{
+  struct free_page_desc *d;
+
+  lock_acquire (&page_desc_lock);
+  if (page_desc_free_list == NULL)
+    {
+      uint8_t *slab = palloc_get_page (0);
+      size_t ofs;
+
+      if (slab == NULL)
+        PANIC ("OOM allocating page table");
+      for (ofs = 0; ofs + sizeof (struct page) <= PGSIZE;
+           ofs += sizeof (struct page))
+        {
+          d = (struct free_page_desc *) (slab + ofs);
+          d->next = page_desc_free_list;
+          page_desc_free_list = d;
+        }
+    }
+  d = page_desc_free_list;
+  page_desc_free_list = d->next;
+  lock_release (&page_desc_lock);
+  return (struct page *) d;
+}
+
+/* Returns page descriptor P to the pool. */
+static void
+page_desc_free (struct page *p)
+{
+  struct free_page_desc *d = (struct free_page_desc *) p;
+
+  lock_acquire (&page_desc_lock);
+  d->next = page_desc_free_list;
+  page_desc_free_list = d;
+  lock_release (&page_desc_lock);
+}
+
+/* Returns a new, empty page table, or NULL if out of memory. */
+struct page_table *
+page_table_create (void)
+{
+  return palloc_get_page (PAL_ZERO);
+}
+
+/* Returns the slot for UPAGE in page table PT.  If UPAGE's
+   second-level table does not exist, creates it if CREATE is
+   true, or returns NULL otherwise.  Also returns NULL if memory
+   for the table runs out. */
+static struct page **
+page_table_slot (struct page_table *pt, const void *upage, bool create)
+{
+  struct page **table = pt->tables[pd_no (upage)];
+
+  if (table == NULL)
+    {
+      if (!create)
+        return NULL;
+      table = palloc_get_page (PAL_ZERO);
+      if (table == NULL)
+        return NULL;
+      pt->tables[pd_no (upage)] = table;
+    }
+  return &table[pt_no (upage)];
+}
+
 /* Destroys a page when process exit*/
 void
-destroy_page (struct hash_elem *p_, void *aux)
+destroy_page (struct page *p)
 {
-  struct page *p = hash_entry (p_, struct page, hash_elem);
-  if (p->frame)
+  /* Keep pagedir_destroy() from freeing the zero page. */
+  if (p->zero)
+    pagedir_clear_page (p->thread->pagedir, p->upage);
+  if (p->frame && p->frame->inode != NULL)
+    page_unshare (p);
+  else if (p->frame)
     frame_free (p->frame);
   if(p->sector!=NO_SECTOR){
     reset_swap_bitmap(p->sector);
   }
-  free (p);
+  page_desc_free (p);
 }
 
-/* Destroys page table when process exit */
+/* Destroys page table when process exit.  Walks the tables in
+   address order and frees each one whole. */
 void
 destroy_pages (struct thread* t)
 {
-  struct hash *h = t->pages;
-  if (h != NULL)
-    hash_destroy (h, destroy_page);
+  struct page_table *pt = t->pages;
+  size_t i, j;
+
+  if (pt == NULL)
+    return;
+  /* The page-out daemon may be evicting one of our pages. */
+  lock_acquire(&evict_lock);
+  for (i = 0; i < pd_no (PHYS_BASE); i++)
+    {
+      struct page **table = pt->tables[i];
+      if (table == NULL)
+        continue;
+      for (j = 0; j < PT_ENTRY_CNT; j++)
+        if (table[j] != NULL)
+          {
+            page_wait_transit (table[j]);
+            destroy_page (table[j]);
+          }
+      palloc_free_page (table);
+    }
+  t->pages = NULL;
+  lock_release(&evict_lock);
+  palloc_free_page (pt);
 }
 
 /* find page corresponding to VADDR in a process's pages */
@@ -41,24 +176,22 @@ find_page_by_vaddr (const void *vaddr){
   if (!is_user_vaddr(vaddr))
     return NULL;
 
-  struct page p;
-  struct hash_elem *elem;
-
-  p.upage = (void *) pg_round_down (vaddr);
-  elem = hash_find (thread_current ()->pages, &p.hash_elem);
-  if (elem != NULL)
-    return hash_entry (elem, struct page, hash_elem);
-  return NULL;
+  struct page **slot = page_table_slot (thread_current ()->pages, vaddr,
+                                        false);
+  return slot != NULL ? *slot : NULL;
 }
 
 struct page *
 page_alloc (void *vaddr, bool writable)
 {
   struct thread *t = thread_current ();
-  struct page *p = malloc (sizeof(struct page));
-  if(p == NULL)
+  struct page **slot = page_table_slot (t->pages, vaddr, true);
+  if (slot == NULL)
     PANIC ("OOM allocating page table");
-  
+  if (*slot != NULL)
+    return NULL;                /* Already mapped. */
+
+  struct page *p = page_desc_alloc ();
   p->upage = pg_round_down (vaddr);
   p->writable=writable;
   p->thread = t;
@@ -68,66 +201,165 @@ page_alloc (void *vaddr, bool writable)
   p->file_bytes=0;
   p->file_offset=0;
   p->writeback=false;
-  
-  if (hash_insert (t->pages, &p->hash_elem) != NULL){
-    /* Already mapped. */
-    free (p);
-    p = NULL;
-  }
+  p->zero=false;
+  *slot = p;
   return p;
 }
 void
 page_free(void *vaddr){
   lock_acquire(&evict_lock);
   struct page *p = find_page_by_vaddr(vaddr);
-  if(p==NULL)
+  if(p==NULL){
+    lock_release(&evict_lock);
     return;
+  }
+  page_wait_transit(p);
 
   uninstall_page(p->upage);
-  if (p->frame)
+  if (p->frame){
+    void *kpage=p->frame->base;
     frame_free (p->frame);
+    palloc_free_page (kpage);
+  }
   if(p->sector!=NO_SECTOR){
     reset_swap_bitmap(p->sector);
   }
-  hash_delete(thread_current()->pages,&p->hash_elem);
-  free(p);
+  *page_table_slot(thread_current()->pages,p->upage,false)=NULL;
+  page_desc_free(p);
   lock_release(&evict_lock);
 }
 
-bool
-new_page_alloc (void *fault_addr) {
+/* Obtains a zeroed page from the user pool, evicting a page if
+   none is free.  The page-out daemon normally keeps enough frames
+   free that no eviction is needed here; wakes it when free frames
+   run low. */
+static void *
+page_get_kpage (void){
   void* kpage=palloc_get_page(PAL_USER|PAL_ZERO);
   while(kpage==NULL){
+    sema_up(&pageout_sema);
     page_swap_out_clock();
     kpage=palloc_get_page(PAL_USER|PAL_ZERO);
   }
+  if(frame_free_cnt()<pageout_low)
+    sema_up(&pageout_sema);
+  return kpage;
+}
+
+/* Adds a new anonymous page at FAULT_ADDR, for stack growth.
+   Unless WRITE, it starts out as the shared zero page. */
+bool
+new_page_alloc (void *fault_addr, bool write) {
+  if(!write){
+    struct page *p=page_alloc(fault_addr,true);
+    return p!=NULL && page_map_zero(p);
+  }
+
+  void* kpage=page_get_kpage();
 
   struct page* p=page_alloc(fault_addr,true);
-  struct frame *f=frame_alloc();
-  f->base=kpage;
-  f->page=p;
+  struct frame *f=frame_alloc(kpage,p);
   p->frame=f;
-  return install_page(p->upage,kpage,p->writable);
+  bool success=install_page(p->upage,kpage,p->writable);
+  frame_unpin(f);
+  return success;
+}
+
+
+/* Returns the memory mapping of the current process that
+   contains VADDR, or NULL if there is none. */
+static struct process_mapping *
+find_mapping_by_vaddr(const void *vaddr){
+  struct list *mappings=&thread_current()->mapping_list;
+  struct list_elem *e;
+
+  for(e=list_begin(mappings);e!=list_end(mappings);e=list_next(e)){
+    struct process_mapping *m=list_entry(e,struct process_mapping,elem);
+    if(vaddr<m->base)
+      break;
+    if(vaddr<m->base+m->page_cnt*PGSIZE)
+      return m;
+  }
+  return NULL;
 }
 
+/* Creates the page at VADDR of the memory mapping that contains
+   it, if any, on its first touch.  Returns NULL if VADDR is not
+   in a mapping. */
+static struct page *
+mapping_page_alloc(const void *vaddr){
+  struct process_mapping *m=find_mapping_by_vaddr(vaddr);
+  if(m==NULL)
+    return NULL;
+
+  void *upage=pg_round_down(vaddr);
+  off_t offset=upage-m->base;
+  struct page *p=page_alloc(upage,true);
+  if(p==NULL)
+    return NULL;
+  p->writeback=true;
+  p->file=m->file;
+  p->file_offset=offset;
+  p->file_bytes=m->length-offset<PGSIZE ? m->length-offset : PGSIZE;
+  return p;
+}
 
+/* Returns true if none of the PAGE_CNT pages starting at BASE is
+   in use, whether by a page already created or by a memory
+   mapping.  Costs O(mappings), plus one step per page of the
+   range that falls within an existing second-level table. */
 bool
-page_swap_in(struct page *p){
-  void* kpage=palloc_get_page(PAL_USER|PAL_ZERO);
-  while(kpage==NULL){
-    page_swap_out_clock();
-    kpage=palloc_get_page(PAL_USER|PAL_ZERO);
+page_range_is_free(void *base, size_t page_cnt){
+  struct thread *t=thread_current();
+  void *end=base+page_cnt*PGSIZE;
+  struct list_elem *e;
+
+  if(end<=base || !is_user_vaddr(end-1))
+    return false;
+
+  for(e=list_begin(&t->mapping_list);e!=list_end(&t->mapping_list);
+      e=list_next(e)){
+    struct process_mapping *m=list_entry(e,struct process_mapping,elem);
+    if(base<m->base+m->page_cnt*PGSIZE && m->base<end)
+      return false;
+  }
+
+  while(base<end){
+    struct page **table=t->pages->tables[pd_no(base)];
+    if(table==NULL){
+      /* Nothing in this 4 MB region; skip it whole. */
+      base=pg_round_down(base)+((PT_ENTRY_CNT-pt_no(base))<<PGBITS);
+      continue;
+    }
+    if(table[pt_no(base)]!=NULL)
+      return false;
+    base+=PGSIZE;
   }
-  struct frame* f=frame_alloc();
-  f->base=kpage;
-  f->page=p;
+  return true;
+}
+
+bool
+page_swap_in(struct page *p){
+  return page_load(p,page_get_kpage());
+}
+
+/* Maps P, which has no frame, to KPAGE, a page from the user
+   pool, and fills it from swap, from P's file, or with zeros. */
+static bool
+page_load(struct page *p, void *kpage){
+  if(p->file!=NULL && !p->writable && !p->writeback)
+    return page_load_shared(p,kpage);
+
+  struct frame* f=frame_alloc(kpage,p);
   p->frame=f;
   install_page(p->upage,kpage,p->writable);
 
-  lock_acquire(&evict_lock);
+  /* No need for evict_lock: P has no frame on its way out, and
+     the new frame stays pinned until it is filled, so faults here
+     don't wait behind the page-out daemon's writes. */
   if(p->sector!=NO_SECTOR){
     swap_in(p);
-    lock_release(&evict_lock);
+    frame_unpin(f);
     return true;
   }
   else if(p->file!=NULL){
@@ -136,95 +368,518 @@ page_swap_in(struct page *p){
     memset (p->frame->base + read_bytes, 0, PGSIZE - read_bytes);
     
     
-    lock_release(&evict_lock);
+    frame_unpin(f);
     if (read_bytes != p->file_bytes)
       return false;
   }
   else{
-    memset (p->frame->base, 0, PGSIZE);
-    lock_release(&evict_lock);
+    /* page_get_kpage() already zeroed it. */
+    frame_unpin(f);
   }
   return true;
 }
 
+/* Maps the shared zero page read-only at P, an anonymous page
+   with no contents yet. */
+static bool
+page_map_zero(struct page *p){
+  ASSERT (p->frame == NULL && p->file == NULL && p->sector == NO_SECTOR);
+
+  p->zero=install_page(p->upage,zero_page,false);
+  return p->zero;
+}
+
+/* Resolves a fault at FAULT_ADDR, a write fault if WRITE.
+   Anonymous pages that are only read map the shared zero page;
+   the first write replaces it by a private frame. */
 bool
-page_fault_handler(void *fault_addr){
+page_fault_handler(void *fault_addr, bool write){
   if (thread_current ()->pages == NULL){
     return false;
   }
     
 
   struct page *p=find_page_by_vaddr(fault_addr);
+  if (p == NULL)
+    p=mapping_page_alloc(fault_addr);
 
   if (p == NULL){
     if(PHYS_BASE-STACK_PAGE_MAX*PGSIZE>pg_round_down(fault_addr))
       return false;
     if((void *)thread_current()->esp_track - 32 >= fault_addr)
       return false;
-    return new_page_alloc(fault_addr);
+    return new_page_alloc(fault_addr, write);
   }
-  else if(p->frame==NULL){
+  else if(p->zero){
+    if(!write)
+      return false;
+    uninstall_page(p->upage);
+    p->zero=false;
     return page_swap_in(p);
   }
+  else if(p->frame==NULL){
+    if(!write && p->sector==NO_SECTOR && p->file==NULL)
+      return page_map_zero(p);
+    block_sector_t sector=p->sector;
+    bool success=page_swap_in(p);
+    if(success){
+      if(sector!=NO_SECTOR)
+        page_read_around(p,sector);
+      page_fault_ahead(p);
+    }
+    return success;
+  }
   else{
-    return install_page(p->upage,p->frame->base,p->writable);
+    /* The frame may be on its way out; if so, wait until it gets
+       there and bring it back in. */
+    lock_acquire(&evict_lock);
+    page_wait_transit(p);
+    bool evicted=p->frame==NULL;
+    bool success=evicted || install_page(p->upage,p->frame->base,p->writable);
+    lock_release(&evict_lock);
+    return evicted ? page_swap_in(p) : success;
   }
 }
 
-void
-page_swap_out(struct page *p){
-  ASSERT (p->frame != NULL);
-  //ASSERT (p->frame->thread==thread_current());
+/* Maps P to shared frame F.  evict_lock must be held. */
+static void
+page_attach_shared(struct page *p, struct frame *f){
+  frame_share_attach(f,p);
+  p->frame=f;
+  install_page(p->upage,f->base,false);
+}
 
-  bool dirty = pagedir_is_dirty (p->thread->pagedir, p->upage);
+/* Like page_load(), for P, a read-only page of a file such as an
+   executable's code.  If another process already has the same
+   page of the same file in memory, with the same number of bytes
+   read from the file, maps that frame instead of reading the page
+   again, and frees KPAGE. */
+static bool
+page_load_shared(struct page *p, void *kpage){
+  struct inode *inode=file_get_inode(p->file);
+  struct frame *f;
 
-  uninstall_page(p->upage);
-  if(dirty && p->file!=NULL&&p->writeback){
-    file_write_at(p->file,p->frame->base, p->file_bytes, p->file_offset);
-    
-    palloc_free_page (p->frame->base);
-    frame_free(p->frame);
-    p->frame=NULL;
-    return;
+  lock_acquire(&evict_lock);
+  f=frame_share_lookup(inode,p->file_offset,p->file_bytes);
+  if(f!=NULL){
+    page_attach_shared(p,f);
+    lock_release(&evict_lock);
+    palloc_free_page(kpage);
+    return true;
   }
-  if(swap_out(p)){
-    palloc_free_page (p->frame->base);
-    frame_free(p->frame);
-    p->frame=NULL;
+  lock_release(&evict_lock);
+
+  /* Read the page without holding evict_lock.  The frame stays
+     pinned and unshared until it is filled. */
+  f=frame_alloc(kpage,p);
+  off_t read_bytes=file_read_at(p->file,kpage,p->file_bytes,p->file_offset);
+  memset(kpage+read_bytes,0,PGSIZE-read_bytes);
+  if(read_bytes!=p->file_bytes){
+    frame_free(f);
+    palloc_free_page(kpage);
+    return false;
+  }
+
+  /* Another process may have loaded the page meanwhile. */
+  lock_acquire(&evict_lock);
+  struct frame *other=frame_share_lookup(inode,p->file_offset,p->file_bytes);
+  if(other!=NULL){
+    page_attach_shared(p,other);
+    lock_release(&evict_lock);
+    frame_free(f);
+    palloc_free_page(kpage);
+    return true;
+  }
+  frame_share(f,inode,p->file_offset,p->file_bytes);
+  p->frame=f;
+  install_page(p->upage,kpage,false);
+  lock_release(&evict_lock);
+  frame_unpin(f);
+  return true;
+}
+
+/* Removes P's mapping of its shared frame, freeing the frame if
+   P was its last sharer.  The mapping is cleared so that
+   pagedir_destroy() does not free a page others still use.
+   evict_lock must be held. */
+static void
+page_unshare(struct page *p){
+  struct frame *f=p->frame;
+
+  pagedir_clear_page(p->thread->pagedir,p->upage);
+  p->frame=NULL;
+  if(frame_share_detach(f,p)){
+    void *kpage=f->base;
+    frame_free(f);
+    palloc_free_page(kpage);
+  }
+}
+
+/* Evicts shared frame F by unmapping it from every sharer.  Its
+   pages are clean copies of the file, so nothing is written; the
+   sharers read them again on their next fault.  evict_lock must
+   be held. */
+static void
+page_evict_shared(struct frame *f){
+  while(f->inode!=NULL){
+    struct page *q=list_entry(list_front(&f->sharers),struct page,
+                              share_elem);
+    page_unshare(q);
   }
+}
+
+/* Called after P was brought in by a fault.  If the fault
+   continues a sequential run, also brings in the pages that
+   follow P from swap or their files, so that a linear scan does
+   not take one fault per page.  The read-ahead window grows with
+   the run, up to FAULT_AHEAD_MAX pages, and only uses frames
+   that are free above the page-out daemon's low watermark. */
+static void
+page_fault_ahead(struct page *p){
+  struct thread *t=thread_current();
+  size_t free_cnt=frame_free_cnt();
+  size_t cnt, i;
+
+  if(t->fault_last!=NULL && p->upage==t->fault_last+PGSIZE)
+    t->fault_run++;
   else
+    t->fault_run=0;
+  t->fault_last=p->upage;
+
+  if(t->fault_run==0 || free_cnt<=pageout_low)
+    return;
+  cnt=t->fault_run<FAULT_AHEAD_MAX ? t->fault_run : FAULT_AHEAD_MAX;
+  if(cnt>(free_cnt-pageout_low)/2)
+    cnt=(free_cnt-pageout_low)/2;
+
+  for(i=1;i<=cnt;i++){
+    struct page *q=find_page_by_vaddr(p->upage+i*PGSIZE);
+    if(q==NULL)
+      q=mapping_page_alloc(p->upage+i*PGSIZE);
+    if(q==NULL || q->frame!=NULL || (q->sector==NO_SECTOR && q->file==NULL))
+      break;
+    void *kpage=palloc_get_page(PAL_USER);
+    if(kpage==NULL)
+      break;
+    if(!page_load(q,kpage))
+      break;
+    /* The next fault past what we read counts as sequential. */
+    t->fault_last=q->upage;
+  }
+}
+
+/* Called after P was brought in from swap SECTOR by a fault.
+   Also brings in the other pages of P's window that were swapped
+   out to the same swap cluster, in slot order, since they sit
+   right next to P's slot on disk: a process coming back to a
+   region it used before then takes one fault for it instead of
+   one per page.  Like page_fault_ahead(), only uses frames that
+   are free above the page-out daemon's low watermark. */
+static void
+page_read_around(struct page *p, block_sector_t sector){
+  block_sector_t cluster=sector/(PAGE_SECTORS*SWAP_CLUSTER);
+  void *window=p->upage-(pg_no(p->upage)%SWAP_CLUSTER)*PGSIZE;
+  size_t i;
+
+  for(i=0;i<SWAP_CLUSTER;i++){
+    struct page *q=find_page_by_vaddr(window+i*PGSIZE);
+    void *kpage;
+
+    if(q==NULL || q==p || q->frame!=NULL || q->sector==NO_SECTOR
+       || q->sector/(PAGE_SECTORS*SWAP_CLUSTER)!=cluster)
+      continue;
+    if(frame_free_cnt()<=pageout_low)
+      break;
+    kpage=palloc_get_page(PAL_USER);
+    if(kpage==NULL || !page_load(q,kpage))
+      break;
+  }
+}
+
+/* Returns true if KPAGE holds only zeros. */
+static bool
+page_is_zero(const void *kpage){
+  const uint32_t *word=kpage;
+  size_t i;
+
+  for(i=0;i<PGSIZE/sizeof *word;i++)
+    if(word[i]!=0)
+      return false;
+  return true;
+}
+
+/* Waits until P is not in transit.  evict_lock must be held; it
+   is released while waiting. */
+static void
+page_wait_transit(struct page *p){
+  while(p->frame!=NULL && p->frame->evicting)
+    cond_wait(&transit_cond,&evict_lock);
+}
+
+/* Writes P, a page in transit, to its file or to swap if needed.
+   DIRTY says whether it was modified.  Called without
+   evict_lock. */
+static void
+page_write_out(struct page *p, bool dirty){
+  void *kpage=p->frame->base;
+
+  if(dirty && p->file!=NULL && p->writeback)
+    file_write_at(p->file,kpage,p->file_bytes,p->file_offset);
+  else if(p->file!=NULL && p->writeback){
+    /* A clean page of a mapped file is just dropped, and read
+       from the file again on the next fault. */
+  }
+  else if(p->file==NULL && page_is_zero(kpage)){
+    /* An anonymous page of zeros goes back to being untouched,
+       instead of taking up swap. */
+  }
+  else if(!swap_out(p))
     PANIC("NO SWAP BLOCK");
 }
 
+/* Returns true if page A should be written out before page B:
+   pages of one process in address order, so that the pages of a
+   swap cluster go out in slot order. */
+static bool
+page_evict_before(const struct page *a, const struct page *b){
+  if(a->thread->tid!=b->thread->tid)
+    return a->thread->tid<b->thread->tid;
+  return a->upage<b->upage;
+}
+
+/* Evicts up to MAX pages, at most PAGEOUT_BATCH, chosen by the
+   clock algorithm, and returns how many were evicted.  Shared
+   frames are clean and are dropped on the spot.  The other
+   victims are all unmapped and put in transit together, then
+   written out one after another with evict_lock released, each
+   freed as soon as its own write is done.  evict_lock must be
+   held on entry and is held again on return. */
+static size_t
+page_evict_batch(size_t max){
+  struct frame *victims[PAGEOUT_BATCH];
+  bool dirty[PAGEOUT_BATCH];
+  size_t evicted=0, cnt=0, i, j;
+
+  ASSERT (max<=PAGEOUT_BATCH);
+
+  while(evicted+cnt<max){
+    struct frame *f=frame_find_victim();
+    if(f==NULL)
+      break;
+    if(f->inode!=NULL){
+      page_evict_shared(f);
+      evicted++;
+      continue;
+    }
+
+    /* P may belong to another process than ours.  Once it is
+       unmapped, its owner faults if it touches it, and waits. */
+    struct page *p=f->page;
+    bool d=pagedir_is_dirty(p->thread->pagedir,p->upage);
+    pagedir_clear_page(p->thread->pagedir,p->upage);
+    for(j=cnt;j>0 && page_evict_before(p,victims[j-1]->page);j--){
+      victims[j]=victims[j-1];
+      dirty[j]=dirty[j-1];
+    }
+    victims[j]=f;
+    dirty[j]=d;
+    cnt++;
+  }
+  if(cnt==0)
+    return evicted;
+
+  transit_cnt+=cnt;
+  lock_release(&evict_lock);
+  for(i=0;i<cnt;i++){
+    struct frame *f=victims[i];
+    struct page *p=f->page;
+    void *kpage=f->base;
+
+    page_write_out(p,dirty[i]);
+
+    lock_acquire(&evict_lock);
+    p->frame=NULL;
+    frame_free(f);
+    palloc_free_page(kpage);
+    transit_cnt--;
+    cond_broadcast(&transit_cond,&evict_lock);
+    if(i+1<cnt)
+      lock_release(&evict_lock);
+  }
+  return evicted+cnt;
+}
+
+/* Makes sure the user page containing UADDR is in memory and
+   keeps it there until page_unpin(), so that the kernel can
+   access it without faulting, e.g. while holding file system
+   locks.  If WRITE, the page must be writable, and a page still
+   mapped to the zero page gets its own frame.  Returns false if
+   UADDR is not a valid user address.
+   A resident page is pinned under frame_lock alone, without
+   evict_lock, so that system calls do not queue behind the
+   evictor.  A page that is not resident, or in transit, is
+   brought in by the fault handler first. */
+bool
+page_pin(const void *uaddr, bool write){
+  if(!is_user_vaddr(uaddr))
+    return false;
+  for(;;){
+    struct page *p=find_page_by_vaddr(uaddr);
+    if(p!=NULL && write && !p->writable)
+      return false;
+    if(p!=NULL && frame_pin_page(p))
+      return true;
+    if(p!=NULL && p->zero && !write){
+      /* The zero page is never evicted. */
+      return true;
+    }
+
+    /* The page may be evicted again before we pin it; if so, just
+       try again. */
+    if(!page_fault_handler((void *)uaddr,write))
+      return false;
+  }
+}
+
+/* Releases the pin taken by page_pin() on the user page
+   containing UADDR. */
+void
+page_unpin(const void *uaddr){
+  struct page *p=find_page_by_vaddr(uaddr);
+  if(p!=NULL && p->frame!=NULL)
+    frame_unpin(p->frame);
+}
+
+/* Returns true if P is a memory-mapped page that is in memory
+   and has been modified since it was last written back.  A page
+   in transit is waited for, since its eviction writes it back.
+   evict_lock must be held. */
+static bool
+page_needs_writeback(struct page *p){
+  if(p==NULL || !p->writeback)
+    return false;
+  page_wait_transit(p);
+  return p->frame!=NULL && pagedir_is_dirty(p->thread->pagedir,p->upage);
+}
+
+/* Writes the modified pages among the PAGE_CNT memory-mapped
+   pages starting at BASE back to their file.  Each run of
+   adjacent modified pages goes out in a single write, covering
+   exactly the pages' file bytes, so a partial last page does not
+   extend the file.  Clean pages and pages not in memory, which
+   were written back when they were evicted, cost nothing.
+   The pages of a run are pinned, not locked, while it is
+   written, so eviction of other pages goes on meanwhile. */
+void
+page_writeback(void *base, size_t page_cnt){
+  size_t i=0;
+
+  while(i<page_cnt){
+    struct page *first=find_page_by_vaddr(base+i*PGSIZE);
+    off_t bytes=0;
+    size_t j, k;
+
+    lock_acquire(&evict_lock);
+    for(j=i;j<page_cnt;j++){
+      struct page *p=find_page_by_vaddr(base+j*PGSIZE);
+      if(!page_needs_writeback(p) || p->file!=first->file
+         || p->file_offset!=first->file_offset+bytes)
+        break;
+      frame_pin(p->frame);
+      pagedir_set_dirty(p->thread->pagedir,p->upage,false);
+      bytes+=p->file_bytes;
+    }
+    lock_release(&evict_lock);
+    if(j==i){
+      i++;
+      continue;
+    }
+
+    /* The run is contiguous in user memory, which stays mapped
+       while it is pinned. */
+    file_write_at(first->file,first->upage,bytes,first->file_offset);
+    for(k=i;k<j;k++)
+      frame_unpin(find_page_by_vaddr(base+k*PGSIZE)->frame);
+    i=j;
+  }
+}
+
+/* Evicts up to MAX pages, at most PAGEOUT_BATCH, and returns the
+   number evicted.  The victims are chosen with evict_lock held,
+   so that their owners cannot free them meanwhile. */
+static size_t
+page_evict(size_t max){
+  lock_acquire(&evict_lock);
+  size_t cnt=page_evict_batch(max);
+  lock_release(&evict_lock);
+  return cnt;
+}
+
+/* Evicts one page, for a thread that found no free frame.  If
+   every frame is pinned or already in transit, waits for a page
+   in transit to finish instead. */
 void
 page_swap_out_clock(){
-  struct frame* victim=frame_find_victim();
-  if(victim==NULL)
-    PANIC("NO VICTIM");
   lock_acquire(&evict_lock);
-  page_swap_out(victim->page);
+  if(page_evict_batch(1)==0){
+    if(transit_cnt==0)
+      PANIC("NO VICTIM");
+    cond_wait(&transit_cond,&evict_lock);
+  }
   lock_release(&evict_lock);
 }
 
+/* Sets up the shared zero page and the page descriptor pool. */
+void
+page_init(void){
+  zero_page=palloc_get_page(PAL_ASSERT|PAL_ZERO);
+  lock_init(&page_desc_lock);
+  cond_init(&transit_cond);
+  transit_cnt=0;
+}
 
-/* Returns a hash value for the page that E refers to. */
-unsigned
-page_hash (const struct hash_elem *e, void *aux UNUSED)
-{
-  const struct page *p = hash_entry (e, struct page, hash_elem);
-  return ((unsigned) p->upage) >> PGBITS;
+/* Starts the page-out daemon. */
+void
+pageout_init(void){
+  size_t frame_cnt=frame_total_cnt();
+
+  pageout_low=PAGEOUT_LOW_WATER;
+  pageout_high=PAGEOUT_HIGH_WATER;
+  if(pageout_low>frame_cnt/8)
+    pageout_low=frame_cnt/8;
+  if(pageout_high>frame_cnt/4)
+    pageout_high=frame_cnt/4;
+  sema_init(&pageout_sema,0);
+  thread_create("pageout",PRI_DEFAULT,pageout_daemon,NULL);
 }
 
-bool
-page_less (const struct hash_elem *a_, const struct hash_elem *b_,
-           void *aux UNUSED)
-{
-  const struct page *a = hash_entry (a_, struct page, hash_elem);
-  const struct page *b = hash_entry (b_, struct page, hash_elem);
+/* Page-out daemon.  Whenever free frames drop below the low
+   watermark, evicts pages, writing them to swap or back to their
+   files, until the high watermark is reached, so that page
+   faults find a free frame without waiting for a disk write.
+   Pages go out in batches of up to PAGEOUT_BATCH; threads that
+   run out of frames meanwhile evict pages of their own in
+   parallel, so several writes can be queued on the disk. */
+static void
+pageout_daemon(void *aux UNUSED){
+  for(;;){
+    sema_down(&pageout_sema);
+    for(;;){
+      size_t free_cnt=frame_free_cnt();
+      size_t want;
 
-  return a->upage < b->upage;
+      if(free_cnt>=pageout_high)
+        break;
+      want=pageout_high-free_cnt;
+      if(want>PAGEOUT_BATCH)
+        want=PAGEOUT_BATCH;
+      if(page_evict(want)==0)
+        break;
+    }
+  }
 }
 
+
 /* Adds a mapping from user virtual address UPAGE to kernel
    virtual address KPAGE to the page table.
    If WRITABLE is true, the user process may modify the page;
@@ -1,19 +1,32 @@
 #ifndef VM_PAGE_H
 #define VM_PAGE_H
 
-#include <hash.h>
+#include <list.h>
 #include "devices/block.h"
 #include "filesys/off_t.h"
 #include "threads/synch.h"
+#include "threads/vaddr.h"
 #include "userprog/syscall.h"
 
+/* Default free frame watermarks for the page-out daemon, which
+   starts evicting pages when fewer than PAGEOUT_LOW_WATER frames
+   are free and stops once PAGEOUT_HIGH_WATER are.  Both are
+   scaled down for small user pools. */
+#define PAGEOUT_LOW_WATER 16
+#define PAGEOUT_HIGH_WATER 32
+
+/* Most pages the page-out daemon has in transit at once. */
+#define PAGEOUT_BATCH 8
+
+/* Maximum number of pages brought in ahead of a fault that
+   continues a sequential run of faults. */
+#define FAULT_AHEAD_MAX 8
+
 struct page {
     void *upage;                 /* User virtual address. */
     bool writable;             /* Read-only page? */
     struct thread *thread;
 
-    struct hash_elem hash_elem;
-    
     struct frame *frame;        /* Page frame. */
 
     block_sector_t sector;       /* Starting sector of swap area, or -1. */
@@ -23,21 +36,40 @@ struct page {
     off_t file_bytes;           /* Bytes to read/write, 1...PGSIZE. */
 
     bool writeback;
+    bool zero;                   /* Mapped to the shared zero page? */
+
+    struct list_elem share_elem; /* Element in frame's sharers, if shared. */
+};
+
+/* Number of entries in each level of a page_table. */
+#define PT_ENTRY_CNT (PGSIZE / sizeof (void *))
+
+/* A process's supplemental page table: a two-level radix tree
+   laid out like the x86 page directory.  The first level is
+   indexed by pd_no() of a user address and the second by pt_no(),
+   and each level fills exactly one page.  Second-level tables
+   are allocated as needed. */
+struct page_table {
+    struct page **tables[PT_ENTRY_CNT];
 };
 
-void destroy_page (struct hash_elem *p_, void *aux);
+struct page_table *page_table_create (void);
+void destroy_page (struct page *p);
 void destroy_pages (struct thread *t);
 struct page* find_page_by_vaddr (const void *vaddr);
 struct page* page_alloc (void *vaddr, bool writable);
 void page_free(void *vaddr);
-bool page_fault_handler(void *fault_addr);
-bool new_page_alloc (void *fault_addr) ;
+bool page_fault_handler(void *fault_addr, bool write);
+bool new_page_alloc (void *fault_addr, bool write);
 bool page_swap_in(struct page *p);
-void page_swap_out(struct page *p);
 void page_swap_out_clock(void);
+void page_writeback(void *base, size_t page_cnt);
+bool page_pin(const void *uaddr, bool write);
+void page_unpin(const void *uaddr);
+bool page_range_is_free(void *base, size_t page_cnt);
+void page_init(void);
+void pageout_init(void);
 
-unsigned page_hash (const struct hash_elem *e, void *aux);
-bool page_less (const struct hash_elem *a_, const struct hash_elem *b_,void *aux);
 bool install_page (void *upage, void *kpage, bool writable);
 bool uninstall_page (void *vaddr);
 #endif
\ No newline at end of file
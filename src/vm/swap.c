@@ -1,19 +1,49 @@
 #include "vm/swap.h"
+#include <hash.h>
+#include <list.h>
+#include "threads/malloc.h"
 
 /* swap device. */
 struct block *swap_device;
 
 /*bookkeeping of swap sectors */
 struct bitmap *swap_bitmap;
+/* Protects swap_bitmap only.  Transfers run without it, so
+   several swap-ins and swap-outs can be queued on the disk at
+   once instead of waiting for each other's whole page. */
 struct lock swap_lock;
 
-/* Number of sectors per page. */
-#define PAGE_SECTORS 8
+/* A swap cluster, protected by swap_lock.  An owned cluster is in
+   cluster_index under its owner and window.  An unowned cluster
+   with no slots in use is on free_clusters. */
+struct swap_cluster {
+    tid_t owner;                /* Owning process, or TID_ERROR. */
+    uintptr_t window;           /* Virtual page number / SWAP_CLUSTER. */
+    size_t used_cnt;            /* Slots in use. */
+    struct hash_elem hash_elem; /* Element in cluster_index. */
+    struct list_elem free_elem; /* Element in free_clusters. */
+};
+
+static struct swap_cluster *clusters;
+static size_t cluster_cnt;
+static struct hash cluster_index;
+static struct list free_clusters;
+/* Where to start looking for a free slot outside any cluster we
+   own: just past the last cluster handed out. */
+static size_t cluster_cursor;
+
+static hash_hash_func cluster_hash;
+static hash_less_func cluster_less;
+
+static size_t swap_alloc_slot (struct page *);
+static void swap_free_slot (size_t slot);
 
 /* Sets up swap. */
 void
 swap_init ()
 {    
+    size_t i;
+
     lock_init (&swap_lock);
     lock_init (&evict_lock);
     swap_device = block_get_role (BLOCK_SWAP);
@@ -26,27 +56,157 @@ swap_init ()
                                    / PAGE_SECTORS);
     if (swap_bitmap == NULL)
       PANIC ("OOM allocating swap bitmap");
+
+    cluster_cnt = bitmap_size (swap_bitmap) / SWAP_CLUSTER;
+    clusters = malloc (cluster_cnt * sizeof *clusters);
+    if (clusters == NULL && cluster_cnt > 0)
+      PANIC ("OOM allocating swap clusters");
+    hash_init (&cluster_index, cluster_hash, cluster_less, NULL);
+    list_init (&free_clusters);
+    for (i = 0; i < cluster_cnt; i++){
+      clusters[i].owner = TID_ERROR;
+      clusters[i].used_cnt = 0;
+      list_push_back (&free_clusters, &clusters[i].free_elem);
+    }
+    cluster_cursor = 0;
 }   
 
-/* Swaps in page P */
+/* Returns a hash value for cluster E. */
+static unsigned
+cluster_hash (const struct hash_elem *e, void *aux UNUSED)
+{
+    const struct swap_cluster *c = hash_entry (e, struct swap_cluster,
+                                               hash_elem);
+    return hash_int (c->owner) ^ hash_int (c->window);
+}
+
+/* Returns true if cluster A precedes cluster B. */
+static bool
+cluster_less (const struct hash_elem *a_, const struct hash_elem *b_,
+              void *aux UNUSED)
+{
+    const struct swap_cluster *a = hash_entry (a_, struct swap_cluster,
+                                               hash_elem);
+    const struct swap_cluster *b = hash_entry (b_, struct swap_cluster,
+                                               hash_elem);
+
+    if (a->owner != b->owner)
+      return a->owner < b->owner;
+    return a->window < b->window;
+}
+
+/* Returns the cluster that OWNER holds for WINDOW, or NULL if
+   there is none.  swap_lock must be held. */
+static struct swap_cluster *
+cluster_lookup (tid_t owner, uintptr_t window)
+{
+    struct swap_cluster key;
+    struct hash_elem *e;
+
+    key.owner = owner;
+    key.window = window;
+    e = hash_find (&cluster_index, &key.hash_elem);
+    return e != NULL ? hash_entry (e, struct swap_cluster, hash_elem) : NULL;
+}
+
+/* Marks SLOT in use and updates its cluster's bookkeeping.
+   swap_lock must be held. */
+static void
+swap_take_slot (size_t slot)
+{
+    size_t c = slot / SWAP_CLUSTER;
+
+    bitmap_mark (swap_bitmap, slot);
+    if (c < cluster_cnt){
+      if (clusters[c].used_cnt++ == 0 && clusters[c].owner == TID_ERROR)
+        list_remove (&clusters[c].free_elem);
+    }
+}
+
+/* Allocates a swap slot for page P and returns it, or
+   BITMAP_ERROR if swap is full.  Prefers P's own slot in the
+   cluster its process holds for P's window, then claims a free
+   cluster for the window, and only then takes any free slot.
+   The first two take constant time.  swap_lock must be held. */
+static size_t
+swap_alloc_slot (struct page *p)
+{
+    uintptr_t pg = pg_no (p->upage);
+    uintptr_t window = pg / SWAP_CLUSTER;
+    size_t ofs = pg % SWAP_CLUSTER;
+    struct swap_cluster *c;
+    size_t slot;
+
+    ASSERT (lock_held_by_current_thread (&swap_lock));
+
+    c = cluster_lookup (p->thread->tid, window);
+    if (c != NULL){
+      /* A cluster we already hold for this window.  Our slot in it
+         may have gone to some other page as a last resort. */
+      slot = (c - clusters) * SWAP_CLUSTER + ofs;
+      if (!bitmap_test (swap_bitmap, slot)){
+        swap_take_slot (slot);
+        return slot;
+      }
+    }
+    else if (!list_empty (&free_clusters)){
+      /* A fresh cluster. */
+      c = list_entry (list_pop_front (&free_clusters),
+                      struct swap_cluster, free_elem);
+      c->owner = p->thread->tid;
+      c->window = window;
+      hash_insert (&cluster_index, &c->hash_elem);
+      cluster_cursor = (c - clusters + 1) % cluster_cnt;
+      slot = (c - clusters) * SWAP_CLUSTER + ofs;
+      bitmap_mark (swap_bitmap, slot);
+      c->used_cnt = 1;
+      return slot;
+    }
+
+    /* Any free slot at all. */
+    slot = bitmap_scan (swap_bitmap, cluster_cursor * SWAP_CLUSTER, 1, false);
+    if (slot == BITMAP_ERROR)
+      slot = bitmap_scan (swap_bitmap, 0, 1, false);
+    if (slot != BITMAP_ERROR)
+      swap_take_slot (slot);
+    return slot;
+}
+
+/* Frees swap SLOT, giving up its cluster once the cluster is
+   empty.  swap_lock must be held. */
+static void
+swap_free_slot (size_t slot)
+{
+    size_t c = slot / SWAP_CLUSTER;
+
+    ASSERT (lock_held_by_current_thread (&swap_lock));
+
+    bitmap_reset (swap_bitmap, slot);
+    if (c < cluster_cnt && --clusters[c].used_cnt == 0){
+      if (clusters[c].owner != TID_ERROR){
+        hash_delete (&cluster_index, &clusters[c].hash_elem);
+        clusters[c].owner = TID_ERROR;
+      }
+      list_push_back (&free_clusters, &clusters[c].free_elem);
+    }
+}
+
+/* Swaps in page P, reading the whole page with one disk
+   command. */
 void
 swap_in (struct page *p)
 {
-    size_t i;
-
     ASSERT (p->frame != NULL);
     ASSERT (p->frame->thread==thread_current());
     ASSERT (p->sector != NO_SECTOR);
 
+    block_read_multiple (swap_device, p->sector, PAGE_SECTORS,
+                         p->frame->base);
 
     lock_acquire (&swap_lock);
-    for (i=0;i<PAGE_SECTORS;i++){
-        block_read (swap_device, p->sector + i,
-                  p->frame->base + i * BLOCK_SECTOR_SIZE);
-    }
-    bitmap_reset (swap_bitmap, p->sector / PAGE_SECTORS);
-    p->sector = NO_SECTOR;
+    swap_free_slot (p->sector / PAGE_SECTORS);
     lock_release (&swap_lock);
+    p->sector = NO_SECTOR;
 }
 
 /* Swaps out page P, which must have a locked frame. */
@@ -54,24 +214,18 @@ bool
 swap_out (struct page *p)
 {
     size_t swap_sector;
-    size_t i;
 
     ASSERT (p->frame != NULL);
     
     lock_acquire (&swap_lock);
-    swap_sector = bitmap_scan_and_flip (swap_bitmap, 0, 1, false);
-    if (swap_sector == BITMAP_ERROR){
-        lock_release (&swap_lock);
+    swap_sector = swap_alloc_slot (p);
+    lock_release (&swap_lock);
+    if (swap_sector == BITMAP_ERROR)
         return false;
-    }
 
     p->sector = swap_sector * PAGE_SECTORS;
-
-    for (i=0;i<PAGE_SECTORS;i++){
-      block_write (swap_device, p->sector + i,
-                   p->frame->base + i * BLOCK_SECTOR_SIZE);
-    }
-    lock_release (&swap_lock);
+    block_write_multiple (swap_device, p->sector, PAGE_SECTORS,
+                          p->frame->base);
     
     return true;
 }
@@ -79,6 +233,6 @@ swap_out (struct page *p)
 
 void reset_swap_bitmap(block_sector_t sector){
   lock_acquire (&swap_lock);
-  bitmap_reset (swap_bitmap, sector / PAGE_SECTORS);
+  swap_free_slot (sector / PAGE_SECTORS);
   lock_release (&swap_lock);
 }
\ No newline at end of file
@@ -12,6 +12,17 @@
 
 #define NO_SECTOR 4294967295U
 
+/* Number of sectors per page. */
+#define PAGE_SECTORS 8
+
+/* Swap slots are grouped into clusters of SWAP_CLUSTER slots.  A
+   cluster is handed out whole to one process for one aligned
+   window of SWAP_CLUSTER virtual pages, and each page of the
+   window always goes to the same slot within it, so neighbouring
+   virtual pages end up in neighbouring slots and can be read
+   around or written out together. */
+#define SWAP_CLUSTER 16
+
 struct lock evict_lock;
 
 void swap_init (void);